@@ -0,0 +1,48 @@
+/****************************************************************************
+ * bootloader/src/cm3_cyccnt.h
+ *
+ *   Copyright (C) 2020 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include "LPC176x5x.h"
+
+/*
+ * Cortex-M3 DWT cycle counter, used to time the bootloader
+ * operations. At 72 MHz it wraps around every 59 s.
+ */
+
+static inline void cm3_cyccnt_enable(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t cm3_cyccnt_read(void)
+{
+	return DWT->CYCCNT;
+}
+
+static inline uint32_t cm3_cyccnt_to_us(uint32_t cycles, uint32_t cpu_clk_khz)
+{
+	return (uint32_t)(((uint64_t)cycles * 1000) / cpu_clk_khz);
+}
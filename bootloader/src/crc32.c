@@ -0,0 +1,78 @@
+/****************************************************************************
+ * bootloader/src/crc32.c
+ *
+ *   Copyright (C) 2020 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include "crc32.h"
+
+/*
+ * Slicing-by-4 tables: crc_table[0] is the classic byte-wise table,
+ * crc_table[n] advances a byte through n more zero bytes. They are
+ * built at boot, reading them from RAM avoids the flash wait states.
+ */
+static uint32_t crc_table[4][256];
+
+void crc32_init(void)
+{
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		uint32_t c = i;
+
+		for (int k = 0; k < 8; k++)
+		{
+			c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+		}
+		crc_table[0][i] = c;
+	}
+
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		for (int t = 1; t < 4; t++)
+		{
+			uint32_t c = crc_table[t - 1][i];
+			crc_table[t][i] = (c >> 8) ^ crc_table[0][c & 0xFF];
+		}
+	}
+}
+
+__attribute__ ((long_call, noinline, section (".data")))
+uint32_t crc32_update(uint32_t crc, const uint32_t* data, size_t len)
+{
+	crc = ~crc;
+
+	for (; len >= 4; len -= 4)
+	{
+		crc ^= *data++;
+		crc = crc_table[3][crc & 0xFF] ^
+			crc_table[2][(crc >> 8) & 0xFF] ^
+			crc_table[1][(crc >> 16) & 0xFF] ^
+			crc_table[0][crc >> 24];
+	}
+
+	const uint8_t* tail = (const uint8_t*)data;
+
+	while (len--)
+	{
+		crc = (crc >> 8) ^ crc_table[0][(crc ^ *tail++) & 0xFF];
+	}
+
+	return ~crc;
+}
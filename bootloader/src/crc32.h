@@ -0,0 +1,37 @@
+/****************************************************************************
+ * bootloader/src/crc32.h
+ *
+ *   Copyright (C) 2020 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Build the CRC-32 lookup tables in RAM, must be called once before
+ * crc32_update()
+ */
+void crc32_init(void);
+
+/*
+ * CRC-32 (same as zlib's crc32()), processing a 32bit word per step.
+ * Start with crc = 0, data must be word aligned.
+ */
+uint32_t crc32_update(uint32_t crc, const uint32_t* data, size_t len);
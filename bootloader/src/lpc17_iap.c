@@ -97,3 +97,18 @@ enum iap_err lpc17_iap_blank_check(uint8_t start_sector, uint8_t end_sector)
 
 	return (enum iap_err)inout[0];
 }
+
+__attribute__ ((long_call, noinline, section (".data")))
+enum iap_err lpc17_iap_compare(uint32_t* dest, uint32_t* src, size_t len)
+{
+	uint32_t inout[5] = {
+		(uint32_t)iap_compare,
+		(uint32_t)dest,
+		(uint32_t)src,
+		(uint32_t)len,
+	};
+
+	iap_entry(inout, inout);
+
+	return (enum iap_err)inout[0];
+}
@@ -52,3 +52,4 @@ enum iap_err lpc17_iap_prepare_sectors(uint8_t start_sector, uint8_t end_sector)
 enum iap_err lpc17_iap_copy_ram_flash(uint32_t* src_ram, uint32_t* dest_flash, size_t len, uint32_t cpu_clk_khz);
 enum iap_err lpc17_iap_erase_sectors(uint8_t start_sector, uint8_t end_sector, uint32_t cpu_clk_khz);
 enum iap_err lpc17_iap_blank_check(uint8_t start_sector, uint8_t end_sector);
+enum iap_err lpc17_iap_compare(uint32_t* dest, uint32_t* src, size_t len);
@@ -30,6 +30,8 @@
 #include "lpc17_uart.h"
 #include "lpc17_iap.h"
 #include "start_app.h"
+#include "cm3_cyccnt.h"
+#include "crc32.h"
 
 uint32_t* const flash_end_addr = (uint32_t*)0x80000;
 uint32_t* const app_start_addr = (uint32_t*)0x10000;
@@ -42,6 +44,7 @@ const uint8_t boot_end_sec = 15;
 const uint8_t app_start_sec = 16;
 const uint8_t update_start_sec = 23;
 const uint8_t magic_word_sec = 29;
+const uint32_t app_sector_size = 0x8000;
 
 typedef struct
 {
@@ -50,7 +53,24 @@ typedef struct
     uint32_t magic;
 } fw_info;
 
+/*
+ * Application length and CRC-32, stored right before fw_info in the
+ * trailer page. The trailer is copied along with the image, so the
+ * record of the running application sits at the end of the app area.
+ * vector_crc is the CRC-32 of the first page of the image (the vector
+ * table), it binds the record to the image it was written with.
+ */
+typedef struct
+{
+    uint32_t vector_crc;
+    uint32_t length;
+    uint32_t crc;
+} app_info;
+
+#define APP_VECTOR_PAGE 256
+
 const fw_info* fw_header = (fw_info*)((uint32_t)flash_end_addr - sizeof(fw_info));
+const app_info* app_record = (app_info*)((uint32_t)update_start_addr - sizeof(fw_info) - sizeof(app_info));
 
 __attribute__ ((long_call, noinline, section (".data")))
 uint8_t get_sector_number(uint32_t flash)
@@ -67,42 +87,212 @@ uint8_t get_sector_number(uint32_t flash)
     return ret;
 }
 
+/*
+ * Largest block accepted by the IAP "Copy RAM to Flash" command. The
+ * buffer lives in .bss, the 1KiB stack is too small for it.
+ */
+#define IAP_MAX_COPY 4096
+
+static uint32_t copy_buffer[IAP_MAX_COPY / 4];
+
+/*
+ * Pick the largest IAP copy size (4096, 1024, 512 or 256 bytes) that
+ * fits the remaining length and the destination alignment
+ */
 __attribute__ ((long_call, noinline, section (".data")))
-void copy_flash_region(uint32_t* src, uint32_t* dest, size_t len, uint32_t cpu_clk_khz)
+size_t copy_block_size(uint32_t dest, size_t remaining)
 {
-    uint32_t buffer[64];
+    size_t block = IAP_MAX_COPY;
 
-    if (len % 256) return;
+    while (block > 256 && (block > remaining || (dest % block) != 0))
+    {
+        block = (block == IAP_MAX_COPY) ? 1024 : block / 2;
+    }
+    return block;
+}
 
-    for (size_t i = 0; i < len; i += 256, src += 64, dest += 64)
+__attribute__ ((long_call, noinline, section (".data")))
+enum iap_err copy_flash_region(uint32_t* src, uint32_t* dest, size_t len, uint32_t cpu_clk_khz)
+{
+    enum iap_err ret;
+
+    if (len % 256) return iap_count_error;
+
+    while (len > 0)
     {
-        for (size_t i = 0; i < 64; i++)
+        size_t block = copy_block_size((uint32_t)dest, len);
+
+        for (size_t i = 0; i < block / 4; i++)
         {
-            buffer[i] = src[i];
+            copy_buffer[i] = src[i];
         }
 
+        /*
+         * The IAP relocks the sector after each copy, so it has to
+         * be prepared again for every block
+         */
         uint8_t sector = get_sector_number((uint32_t)dest);
 
         lpc17_iap_prepare_sectors(sector, sector);
-        lpc17_iap_copy_ram_flash(buffer, dest, 256, cpu_clk_khz);
+        ret = lpc17_iap_copy_ram_flash(copy_buffer, dest, block, cpu_clk_khz);
+        if (ret != iap_cmd_success) return ret;
+
+        src += block / 4;
+        dest += block / 4;
+        len -= block;
     }
+
+    return iap_cmd_success;
 }
 
+/*
+ * Copy the staged application to app sectors app_start_sec up to
+ * end_sec (exclusive), returns the IAP status. Only the sectors that
+ * differ from the staged image are erased and programmed, their count
+ * is returned in updated_sectors. The elapsed time is measured by the
+ * caller, once flash is readable again.
+ */
 __attribute__ ((long_call, noinline, section (".data")))
-void update_app(uint32_t cpu_clk_khz)
+enum iap_err update_app(uint8_t end_sec, uint32_t cpu_clk_khz, uint32_t* updated_sectors)
 {
-    lpc17_iap_prepare_sectors(app_start_sec, update_start_sec - 1);
-    lpc17_iap_erase_sectors(app_start_sec, update_start_sec - 1, cpu_clk_khz);
+    enum iap_err ret = iap_cmd_success;
+
+    *updated_sectors = 0;
+
+    for (uint8_t sector = app_start_sec; sector < end_sec; sector++)
+    {
+        uint32_t offset = (sector - app_start_sec) * app_sector_size;
+        uint32_t* src = update_start_addr + offset / 4;
+        uint32_t* dest = app_start_addr + offset / 4;
 
-    copy_flash_region(update_start_addr, app_start_addr, app_size, cpu_clk_khz);
+        if (lpc17_iap_compare(dest, src, app_sector_size) == iap_cmd_success)
+        {
+            continue;
+        }
+
+        lpc17_iap_prepare_sectors(sector, sector);
+        ret = lpc17_iap_erase_sectors(sector, sector, cpu_clk_khz);
+        if (ret != iap_cmd_success) break;
+
+        ret = copy_flash_region(src, dest, app_sector_size, cpu_clk_khz);
+        if (ret != iap_cmd_success) break;
+
+        (*updated_sectors)++;
+    }
+
+    return ret;
+}
 
+/*
+ * Erase the sector holding the update magic word, so the update isn't
+ * applied again on the next reset
+ */
+__attribute__ ((long_call, noinline, section (".data")))
+void clear_update_flag(uint32_t cpu_clk_khz)
+{
     lpc17_iap_prepare_sectors(magic_word_sec, magic_word_sec);
     lpc17_iap_erase_sectors(magic_word_sec, magic_word_sec, cpu_clk_khz);
+}
+
+/*
+ * Check an image against an app_info record, the CRC computation time
+ * is returned in elapsed_us
+ */
+int image_valid(const uint32_t* base, const app_info* info, uint32_t* elapsed_us)
+{
+    uint32_t start = cm3_cyccnt_read();
+    int valid = info->length <= app_size - 256 && (info->length % 4) == 0 &&
+        crc32_update(0, base, info->length) == info->crc;
+
+    *elapsed_us = cm3_cyccnt_to_us(cm3_cyccnt_read() - start, 72000);
+    return valid;
+}
+
+/*
+ * Verify the application before jumping to it. If it is corrupted but
+ * the staging area still holds the same image, the app is restored
+ * from there. Images without a record (length erased) aren't checked.
+ *
+ * An application programmed over JTAG leaves the record of the last
+ * update in place, so the record must belong to the running image
+ * before anything is restored over it.
+ */
+void verify_app(void)
+{
+    char tmp[128];
+    uint32_t elapsed;
 
     /*
-     * Jump to application code
+     * clear_update_flag() erases the last staging sector (magic_word_sec)
+     * once an update is applied, so only the images that end before it
+     * can be restored
      */
-    start_app((uint32_t*)0x10000);
+    uint32_t restore_max_length = (magic_word_sec - update_start_sec) * app_sector_size;
+
+    if (app_record->length == 0xFFFFFFFF)
+    {
+        lpc17_uart0_write_str_blocking("[BOOTLOADER] No application checksum, skipping verification\r\n");
+        return;
+    }
+
+    if (app_record->vector_crc != 0xFFFFFFFF &&
+        crc32_update(0, app_start_addr, APP_VECTOR_PAGE) != app_record->vector_crc)
+    {
+        lpc17_uart0_write_str_blocking("[BOOTLOADER] Application checksum is for another image, skipping verification\r\n");
+        return;
+    }
+
+    int valid = image_valid(app_start_addr, app_record, &elapsed);
+
+    snprintf(tmp, 128, "[BOOTLOADER] Application CRC %s (%lu bytes, %lu us)\r\n",
+             valid ? "OK" : "MISMATCH", (unsigned long)app_record->length,
+             (unsigned long)elapsed);
+    lpc17_uart0_write_str_blocking(tmp);
+
+    if (valid) return;
+
+    /*
+     * Records written before vector_crc existed can't tell a corrupted
+     * application from one flashed over JTAG: only report the mismatch
+     */
+    if (app_record->vector_crc == 0xFFFFFFFF)
+    {
+        lpc17_uart0_write_str_blocking("[BOOTLOADER] Application checksum isn't bound to the image, not restoring\r\n");
+        return;
+    }
+
+    /*
+     * Copy the record to RAM, restoring the app may overwrite it
+     */
+    app_info expected = *app_record;
+
+    if (expected.length > restore_max_length)
+    {
+        snprintf(tmp, 128, "[BOOTLOADER] Can't restore images over %lu bytes from the staging area\r\n",
+                 (unsigned long)restore_max_length);
+        lpc17_uart0_write_str_blocking(tmp);
+    }
+    else if (image_valid(update_start_addr, &expected, &elapsed))
+    {
+        uint32_t updated_sectors;
+        uint8_t end_sec = app_start_sec + (expected.length + app_sector_size - 1) / app_sector_size;
+
+        lpc17_uart0_write_str_blocking("[BOOTLOADER] Restoring the application from the staging area...\r\n");
+        update_app(end_sec, 72000, &updated_sectors);
+
+        valid = image_valid(app_start_addr, &expected, &elapsed);
+        snprintf(tmp, 128, "[BOOTLOADER] %lu sectors restored, application CRC %s\r\n",
+                 (unsigned long)updated_sectors, valid ? "OK" : "MISMATCH");
+        lpc17_uart0_write_str_blocking(tmp);
+        if (valid) return;
+    }
+
+    /*
+     * There is no other image to fall back to, and the bootloader can't
+     * receive a new one: start the application anyway, it may still be
+     * able to take a firmware update.
+     */
+    lpc17_uart0_write_str_blocking("[BOOTLOADER] ERROR: No valid application image found!\r\n");
 }
 
 __attribute__ ((long_call, noinline, section (".data")))
@@ -113,8 +303,7 @@ void update_bootloader(uint32_t cpu_clk_khz)
 
     copy_flash_region(update_start_addr, boot_start_addr, boot_size, cpu_clk_khz);
 
-    lpc17_iap_prepare_sectors(magic_word_sec, magic_word_sec);
-    lpc17_iap_erase_sectors(magic_word_sec, magic_word_sec, cpu_clk_khz);
+    clear_update_flag(cpu_clk_khz);
 
     /*
      * Jump to application code
@@ -153,6 +342,9 @@ int main(void)
      */
     lpc17_uart0_init(115200, 72000000);
 
+    cm3_cyccnt_enable();
+    crc32_init();
+
     if (fw_header->magic == 0xAAAAAAAA)
     {
         char tmp[128];
@@ -163,7 +355,30 @@ int main(void)
             snprintf(tmp, 128, "[BOOTLOADER] New app firmware update found!\r\nUpdating to %d.%d.%d ...\r\n",
                      fw_header->version[0], fw_header->version[1], fw_header->version[2]);
             lpc17_uart0_write_str_blocking(tmp);
-            update_app(72000);
+            uint32_t updated_sectors;
+            uint32_t start = cm3_cyccnt_read();
+            enum iap_err ret = update_app(update_start_sec, 72000, &updated_sectors);
+
+            /*
+             * Keep the flag if the copy failed, so the update is retried
+             * on the next boot
+             */
+            if (ret == iap_cmd_success)
+            {
+                clear_update_flag(72000);
+            }
+            uint32_t elapsed = cm3_cyccnt_to_us(cm3_cyccnt_read() - start, 72000);
+
+            snprintf(tmp, 128, "[BOOTLOADER] Update %s (IAP status %d), %lu/%d sectors rewritten, took %lu ms\r\n",
+                     ret == iap_cmd_success ? "finished" : "FAILED", ret,
+                     (unsigned long)updated_sectors, update_start_sec - app_start_sec,
+                     (unsigned long)(elapsed / 1000));
+            lpc17_uart0_write_str_blocking(tmp);
+
+            if (ret != iap_cmd_success)
+            {
+                lpc17_uart0_write_str_blocking("[BOOTLOADER] The update will be retried on the next boot\r\n");
+            }
         }
         else if (fw_header->fw_type == 2)
         {
@@ -179,6 +394,8 @@ int main(void)
         }
     }
 
+    verify_app();
+
     /*
      * Jump to application code
      */
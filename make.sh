@@ -40,13 +40,33 @@ elif test "$cmd" = "build"; then
 	fi
     make -j ${JOBS}
 	cd ..
+elif test "$cmd" = "stack"; then
+	git_hash_tag
+	cd nuttx/
+	if [ ! -e .config ]; then
+		echo "Error: Build not configured yet."
+		echo "Please run '$0 configure' before building."
+		exit 1
+	fi
+	# Rebuild everything with the per function stack usage
+	make clean
+	make -j ${JOBS} EXTRADEFINES=-fstack-usage || exit 1
+	cd ..
+	python3 utils/stack_budget.py nuttx/nuttx nuttx apps rffe-app
+	exit $?
+elif test "$cmd" = "host"; then
+	make -C rffe-app/host -j ${JOBS} || exit 1
+	exit 0
 elif test "$cmd" = "clean"; then
 	cd nuttx/
 	make distclean
 	cd ..
 	rm -f apps/external rffe-app/git_version.h
+	make -C rffe-app/host clean
 elif test "$cmd" = "flash"; then
-	openocd -f scripts/openocd/lpc17-cmsis.cfg -c "program nuttx/nuttx.bin 0x10000; reset; shutdown"
+	# Erase the whole application area first, so the record left by the
+	# last firmware update (0x47FEC) doesn't outlive the image it describes
+	openocd -f scripts/openocd/lpc17-cmsis.cfg -c "init; reset halt; flash erase_address 0x10000 0x38000; program nuttx/nuttx.bin 0x10000; reset; shutdown"
 else
 	echo "Error: unknown command ${cmd}"
 fi
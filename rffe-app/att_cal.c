@@ -0,0 +1,211 @@
+/****************************************************************************
+ * rffe-app/att_cal.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/boardctl.h>
+#include <arch/board/board.h>
+#include <nuttx/rf/ioctl.h>
+#include <nuttx/rf/attenuator.h>
+
+#include "att_cal.h"
+
+/*
+ * Highest code accepted by the DAT-31R5-SP (31.5 dB in 0.5 dB steps)
+ */
+#define ATT_CAL_MAX_CODE (ATT_CAL_ENTRIES - 1)
+
+static uint8_t att_cal_tables[ATT_CAL_CHANNELS][ATT_CAL_ENTRIES];
+
+/*
+ * Protects the tables (the console and the SCPI clients reload or
+ * replace them while another thread applies an attenuation) and
+ * serializes the per-channel codes armed on the board with the
+ * /dev/att0 write that shifts them
+ */
+static pthread_mutex_t att_cal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void att_cal_identity(uint8_t table[ATT_CAL_ENTRIES])
+{
+    for (int i = 0; i < ATT_CAL_ENTRIES; i++)
+    {
+        table[i] = i;
+    }
+}
+
+static int att_cal_table_valid(const uint8_t table[ATT_CAL_ENTRIES])
+{
+    for (int i = 0; i < ATT_CAL_ENTRIES; i++)
+    {
+        if (table[i] > ATT_CAL_MAX_CODE)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int att_cal_load(const char* path)
+{
+    uint8_t table[ATT_CAL_ENTRIES];
+    int ret = 0;
+
+    /*
+     * One channel at a time, each table is read into a local copy and
+     * swapped in under the lock
+     */
+    for (int ch = 0; ch < ATT_CAL_CHANNELS; ch++)
+    {
+        if (config_get_att_cal(path, ch, table) < 0 || !att_cal_table_valid(table))
+        {
+            /*
+             * Unreadable or corrupted table, fallback to the
+             * uncalibrated behavior for this channel
+             */
+            att_cal_identity(table);
+            ret = -1;
+        }
+
+        pthread_mutex_lock(&att_cal_lock);
+        memcpy(att_cal_tables[ch], table, ATT_CAL_ENTRIES);
+        pthread_mutex_unlock(&att_cal_lock);
+    }
+
+    return ret;
+}
+
+static int att_cal_index(b16_t att)
+{
+    /*
+     * Round to the nearest 0.5 dB step (b16 >> 15 == 2 * dB)
+     */
+    int32_t index = (att + (1 << 14)) >> 15;
+
+    if (index < 0)
+    {
+        index = 0;
+    }
+    else if (index > ATT_CAL_MAX_CODE)
+    {
+        index = ATT_CAL_MAX_CODE;
+    }
+
+    return index;
+}
+
+int att_cal_apply(b16_t att)
+{
+    struct attenuator_control ctrl;
+    uint8_t codes[ATT_CAL_CHANNELS];
+    int index = att_cal_index(att);
+    int same = 1;
+    int ret = 0;
+
+    pthread_mutex_lock(&att_cal_lock);
+
+    for (int ch = 0; ch < ATT_CAL_CHANNELS; ch++)
+    {
+        codes[ch] = att_cal_tables[ch][index];
+        same &= codes[ch] == codes[0];
+    }
+
+    int fd = open("/dev/att0", O_RDONLY);
+    if (fd < 0)
+    {
+        pthread_mutex_unlock(&att_cal_lock);
+        return fd;
+    }
+
+    /*
+     * The driver shifts the same word to the four attenuators, the
+     * board replaces it with one code per channel for the next write.
+     * Not needed when all channels resolve to the same code.
+     */
+    if (!same)
+    {
+        ret = boardctl(BOARDIOC_ATT_SETCODES, (uintptr_t)codes);
+    }
+
+    if (ret >= 0)
+    {
+        ctrl.attenuation = (b16_t)codes[0] << 15;
+        ret = ioctl(fd, RFIOC_SETATT, (unsigned long)&ctrl);
+
+        /*
+         * The codes weren't latched, don't leave them armed for the
+         * next write
+         */
+        if (ret < 0 && !same)
+        {
+            boardctl(BOARDIOC_ATT_SETCODES, 0);
+        }
+    }
+
+    close(fd);
+    pthread_mutex_unlock(&att_cal_lock);
+
+    return ret;
+}
+
+int att_cal_get_table(int channel, uint8_t table[ATT_CAL_ENTRIES])
+{
+    if (channel < 0 || channel >= ATT_CAL_CHANNELS)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&att_cal_lock);
+    memcpy(table, att_cal_tables[channel], ATT_CAL_ENTRIES);
+    pthread_mutex_unlock(&att_cal_lock);
+    return 0;
+}
+
+int att_cal_set_table(const char* path, int channel, const uint8_t table[ATT_CAL_ENTRIES])
+{
+    int ret;
+
+    if (channel < 0 || channel >= ATT_CAL_CHANNELS || !att_cal_table_valid(table))
+    {
+        return -1;
+    }
+
+    ret = config_set_att_cal(path, channel, table);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    pthread_mutex_lock(&att_cal_lock);
+    memcpy(att_cal_tables[channel], table, ATT_CAL_ENTRIES);
+    pthread_mutex_unlock(&att_cal_lock);
+
+    return 0;
+}
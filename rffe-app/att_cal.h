@@ -0,0 +1,63 @@
+/****************************************************************************
+ * rffe-app/att_cal.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef ATT_CAL_H_
+#define ATT_CAL_H_
+
+#include <stdint.h>
+#include <fixedmath.h>
+
+#include "config_file.h"
+
+/**
+ * @brief Load the attenuator calibration tables from the config file
+ * @return 0 if success, a negative number otherwise
+ */
+int att_cal_load(const char* path);
+
+/**
+ * @brief Resolve and apply a requested attenuation to /dev/att0, each
+ * RF channel attenuator gets its own calibrated code
+ * @param att: Requested attenuation in dB
+ * @return 0 if success, a negative number otherwise
+ */
+int att_cal_apply(b16_t att);
+
+/**
+ * @brief Read the cached calibration table of a RF channel
+ * @param channel: RF channel (0 to ATT_CAL_CHANNELS - 1)
+ * @param table: Buffer to store the hardware codes
+ * @return 0 if success, a negative number otherwise
+ */
+int att_cal_get_table(int channel, uint8_t table[ATT_CAL_ENTRIES]);
+
+/**
+ * @brief Replace the calibration table of a RF channel, both in the
+ * config file and in the cache
+ * @param channel: RF channel (0 to ATT_CAL_CHANNELS - 1)
+ * @param table: Hardware codes, one per 0.5 dB step
+ * @return 0 if success, a negative number otherwise
+ */
+int att_cal_set_table(const char* path, int channel, const uint8_t table[ATT_CAL_ENTRIES]);
+
+#endif
@@ -0,0 +1,69 @@
+/****************************************************************************
+ * rffe-app/boot_time.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "boot_time.h"
+
+static const char* boot_stage_names[BOOT_STAGE_COUNT] =
+{
+    "attenuation restored",
+    "temperature control",
+    "link up",
+    "listeners started",
+    "network configured",
+};
+
+/*
+ * Stored as ms since boot + 1, so 0 means "not reached"
+ */
+static uint32_t boot_times[BOOT_STAGE_COUNT];
+
+void boot_time_mark(enum boot_stage stage)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    boot_times[stage] = ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + 1;
+}
+
+int32_t boot_time_get(enum boot_stage stage)
+{
+    return (int32_t)boot_times[stage] - 1;
+}
+
+void boot_time_print(void)
+{
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        if (boot_times[i] != 0)
+        {
+            printf("Boot: %-22s %6ld ms\n", boot_stage_names[i], (long)boot_time_get(i));
+        }
+    }
+}
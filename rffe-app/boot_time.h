@@ -0,0 +1,60 @@
+/****************************************************************************
+ * rffe-app/boot_time.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef BOOT_TIME_H_
+#define BOOT_TIME_H_
+
+#include <stdint.h>
+
+/*
+ * Startup stages, in the order they usually complete. The network
+ * address is configured in the background, so BOOT_STAGE_NETWORK may
+ * be reached after the listeners are started.
+ */
+enum boot_stage
+{
+    BOOT_STAGE_ATTENUATION,
+    BOOT_STAGE_TEMP_CONTROL,
+    BOOT_STAGE_LINK_UP,
+    BOOT_STAGE_LISTENERS,
+    BOOT_STAGE_NETWORK,
+    BOOT_STAGE_COUNT,
+};
+
+/**
+ * @brief Record the time a startup stage was completed
+ */
+void boot_time_mark(enum boot_stage stage);
+
+/**
+ * @brief Get the time a startup stage was completed
+ * @return Milliseconds since boot, -1 if the stage wasn't reached yet
+ */
+int32_t boot_time_get(enum boot_stage stage);
+
+/**
+ * @brief Print the time of every startup stage reached so far
+ */
+void boot_time_print(void);
+
+#endif
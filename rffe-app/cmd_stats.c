@@ -0,0 +1,117 @@
+/****************************************************************************
+ * rffe-app/cmd_stats.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cmd_stats.h"
+#include "profile.h"
+
+#ifdef CONFIG_EXAMPLES_RFFE_CMD_STATS
+
+static struct cmd_stats cmd_stats_table[CMD_STATS_MAX_COMMANDS];
+static pthread_mutex_t cmd_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int cmd_stats_bucket(uint32_t cycles)
+{
+    uint32_t us = cycles / (profile_frequency() / 1000000);
+    int bucket = 0;
+
+    while (us > 1 && bucket < CMD_STATS_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void cmd_stats_record(int index, int error, uint32_t cycles)
+{
+    struct cmd_stats* stats;
+    int bucket;
+
+    if (index < 0 || index >= CMD_STATS_MAX_COMMANDS)
+    {
+        return;
+    }
+
+    stats = &cmd_stats_table[index];
+    bucket = cmd_stats_bucket(cycles);
+
+    pthread_mutex_lock(&cmd_stats_lock);
+    if (stats->count < UINT32_MAX)
+    {
+        stats->count++;
+    }
+    if (error && stats->errors < UINT32_MAX)
+    {
+        stats->errors++;
+    }
+    if (stats->histogram[bucket] < UINT16_MAX)
+    {
+        stats->histogram[bucket]++;
+    }
+    pthread_mutex_unlock(&cmd_stats_lock);
+}
+
+int cmd_stats_get(int index, struct cmd_stats* stats)
+{
+    if (index < 0 || index >= CMD_STATS_MAX_COMMANDS)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&cmd_stats_lock);
+    *stats = cmd_stats_table[index];
+    pthread_mutex_unlock(&cmd_stats_lock);
+    return 0;
+}
+
+void cmd_stats_reset(void)
+{
+    pthread_mutex_lock(&cmd_stats_lock);
+    memset(cmd_stats_table, 0, sizeof(cmd_stats_table));
+    pthread_mutex_unlock(&cmd_stats_lock);
+}
+
+#else
+
+void cmd_stats_record(int index, int error, uint32_t cycles)
+{
+}
+
+int cmd_stats_get(int index, struct cmd_stats* stats)
+{
+    return -1;
+}
+
+void cmd_stats_reset(void)
+{
+}
+
+#endif
@@ -0,0 +1,97 @@
+/****************************************************************************
+ * rffe-app/cmd_stats.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef CMD_STATS_H_
+#define CMD_STATS_H_
+
+#include <stdint.h>
+
+/*
+ * Per SCPI command counters: invocations, failed invocations and a
+ * log2 histogram of the callback execution time. Bucket i counts the
+ * calls that took [2^i, 2^(i+1)) us, bucket 0 also the ones under 1 us
+ * and the last bucket everything above.
+ *
+ * Without CONFIG_EXAMPLES_RFFE_CMD_STATS CMD_STATS_RECORD() expands to
+ * nothing and no counters are kept.
+ */
+
+#define CMD_STATS_MAX_COMMANDS 80
+#define CMD_STATS_BUCKETS      12
+
+/*
+ * SYSTem:STATistics? binary block: a header followed by one record
+ * per command executed at least once (little endian)
+ */
+#define CMD_STATS_FORMAT_VERSION 1
+
+struct __attribute__((__packed__)) cmd_stats_header
+{
+    uint8_t version;
+    uint8_t buckets;
+    uint16_t records;
+};
+
+struct __attribute__((__packed__)) cmd_stats_record
+{
+    uint8_t index;              /* position in scpi_commands */
+    uint8_t name_len;           /* followed by the command pattern */
+};
+
+/*
+ * Histogram buckets saturate at 65535, the counts at 2^32 - 1
+ */
+struct __attribute__((__packed__)) cmd_stats
+{
+    uint32_t count;
+    uint32_t errors;
+    uint16_t histogram[CMD_STATS_BUCKETS];
+};
+
+#ifdef CONFIG_EXAMPLES_RFFE_CMD_STATS
+#  define CMD_STATS_RECORD(index, error, cycles) cmd_stats_record((index), (error), (cycles))
+#else
+#  define CMD_STATS_RECORD(index, error, cycles)
+#endif
+
+/**
+ * @brief Account one execution of a command (use the macro instead)
+ * @param index Position of the command in scpi_commands
+ * @param error Non zero if the command failed
+ * @param cycles Execution time in profile_cycles() units
+ */
+void cmd_stats_record(int index, int error, uint32_t cycles);
+
+/**
+ * @brief Read the counters of a command
+ * @return 0 if success, a negative number if the index is out of range
+ * or the statistics are disabled
+ */
+int cmd_stats_get(int index, struct cmd_stats* stats);
+
+/**
+ * @brief Clear the counters of all commands
+ */
+void cmd_stats_reset(void);
+
+#endif
@@ -47,6 +47,9 @@ static const int pid_bd_ti_offset = 0x70;
 static const int pid_bd_td_offset = 0x74;
 static const int pid_ac_set_point_offset = 0x78;
 static const int pid_bd_set_point_offset = 0x7C;
+static const int syslog_addr_offset = 0x80;
+static const int syslog_port_offset = 0x84;
+static const int att_cal_offset = 0x100;
 
 int config_get_version(const char* path, uint8_t* version)
 {
@@ -552,3 +555,97 @@ int config_set_temp_control_mode(const char* path, temp_ctrl_mode_t mode)
     close(fd);
     return ret;
 }
+
+int config_get_att_cal(const char* path, int channel, uint8_t table[ATT_CAL_ENTRIES])
+{
+    int fd;
+    int ret;
+
+    if (channel < 0 || channel >= ATT_CAL_CHANNELS)
+    {
+        return -1;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    lseek(fd, att_cal_offset + channel * ATT_CAL_ENTRIES, SEEK_SET);
+    ret = read(fd, table, ATT_CAL_ENTRIES);
+    if (ret > 0) ret = 0;
+
+    close(fd);
+    return ret;
+}
+
+int config_set_att_cal(const char* path, int channel, const uint8_t table[ATT_CAL_ENTRIES])
+{
+    int fd;
+    int ret;
+
+    if (channel < 0 || channel >= ATT_CAL_CHANNELS)
+    {
+        return -1;
+    }
+
+    fd = open(path, O_RDWR);
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    lseek(fd, att_cal_offset + channel * ATT_CAL_ENTRIES, SEEK_SET);
+    ret = write(fd, table, ATT_CAL_ENTRIES);
+    if (ret > 0) ret = 0;
+
+    close(fd);
+    return ret;
+}
+
+int config_get_syslog_addr(const char* path, in_addr_t* addr, uint16_t* port)
+{
+    int fd = open(path, O_RDONLY);
+    int ret;
+
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    lseek(fd, syslog_addr_offset, SEEK_SET);
+    ret = read(fd, addr, 4);
+    if (ret > 0)
+    {
+        lseek(fd, syslog_port_offset, SEEK_SET);
+        ret = read(fd, port, 2);
+    }
+    if (ret > 0) ret = 0;
+
+    close(fd);
+    return ret;
+}
+
+int config_set_syslog_addr(const char* path, in_addr_t addr, uint16_t port)
+{
+    int fd = open(path, O_RDWR);
+    int ret;
+
+    if (fd < 0)
+    {
+        return fd;
+    }
+
+    lseek(fd, syslog_addr_offset, SEEK_SET);
+    ret = write(fd, &addr, 4);
+    if (ret > 0)
+    {
+        lseek(fd, syslog_port_offset, SEEK_SET);
+        ret = write(fd, &port, 2);
+    }
+    if (ret > 0) ret = 0;
+
+    close(fd);
+    return ret;
+}
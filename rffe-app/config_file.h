@@ -40,6 +40,13 @@ typedef enum
     TEMP_CTRL_AUTOMATIC,
 } temp_ctrl_mode_t;
 
+/*
+ * Attenuator calibration tables: one per RF channel (A, B, C and D),
+ * one hardware code per 0.5 dB step from 0 dB to 31.5 dB
+ */
+#define ATT_CAL_CHANNELS 4
+#define ATT_CAL_ENTRIES  64
+
 /**
  * @brief Read the config file version
  * @param version : A pointer to store the version read
@@ -222,4 +229,40 @@ int config_get_temp_control_mode(const char* path, temp_ctrl_mode_t* mode);
  */
 int config_set_temp_control_mode(const char* path, temp_ctrl_mode_t mode);
 
+/**
+ * @brief Read the attenuator calibration table of a RF channel from
+ * the config file
+ * @param channel: RF channel (0 to ATT_CAL_CHANNELS - 1)
+ * @param table: Buffer to store the hardware codes read
+ * @return 0 if success, a negative number otherwise
+ */
+int config_get_att_cal(const char* path, int channel, uint8_t table[ATT_CAL_ENTRIES]);
+
+/**
+ * @brief Write the attenuator calibration table of a RF channel to
+ * the config file
+ * @param channel: RF channel (0 to ATT_CAL_CHANNELS - 1)
+ * @param table: Hardware codes to be written
+ * @return 0 if success, a negative number otherwise
+ */
+int config_set_att_cal(const char* path, int channel, const uint8_t table[ATT_CAL_ENTRIES]);
+
+/**
+ * @brief Read the remote syslog collector from the config file
+ * @param addr: Collector IPv4 address, INADDR_ANY if log shipping is
+ * disabled (network order)
+ * @param port: Collector UDP port (network order)
+ * @return 0 if success, a negative number otherwise
+ */
+int config_get_syslog_addr(const char* path, in_addr_t* addr, uint16_t* port);
+
+/**
+ * @brief Write the remote syslog collector to the config file
+ * @param addr: Collector IPv4 address, INADDR_ANY disables log
+ * shipping (network order)
+ * @param port: Collector UDP port (network order)
+ * @return 0 if success, a negative number otherwise
+ */
+int config_set_syslog_addr(const char* path, in_addr_t addr, uint16_t port);
+
 #endif
@@ -23,10 +23,13 @@
 
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <fixedmath.h>
 #include <string.h>
 
+#include "config_file.h"
+
 struct __attribute__((__packed__)) config_v0
 {
     uint8_t mac[6];
@@ -69,6 +72,47 @@ struct __attribute__((__packed__)) config_v1
     float pid_bd_set_point;
 };
 
+/*
+ * Version 2 appends the attenuator calibration tables at 0x100. They
+ * are initialized as identity maps, so the requested attenuation is
+ * applied unchanged until a calibration is loaded.
+ */
+static void config_migrate_v1_v2(int fd)
+{
+    uint8_t table[ATT_CAL_ENTRIES];
+    uint8_t version = 2;
+
+    for (int i = 0; i < ATT_CAL_ENTRIES; i++)
+    {
+        table[i] = i;
+    }
+
+    lseek(fd, 0x100, SEEK_SET);
+    for (int ch = 0; ch < ATT_CAL_CHANNELS; ch++)
+    {
+        write(fd, table, ATT_CAL_ENTRIES);
+    }
+
+    lseek(fd, offsetof(struct config_v1, version), SEEK_SET);
+    write(fd, &version, 1);
+}
+
+/*
+ * Version 3 adds the remote syslog collector at 0x80, cleared so
+ * log shipping stays disabled until a collector is configured.
+ */
+static void config_migrate_v2_v3(int fd)
+{
+    uint8_t syslog[6] = {0};
+    uint8_t version = 3;
+
+    lseek(fd, 0x80, SEEK_SET);
+    write(fd, syslog, sizeof(syslog));
+
+    lseek(fd, offsetof(struct config_v1, version), SEEK_SET);
+    write(fd, &version, 1);
+}
+
 int config_migrate_latest(const char* path)
 {
     struct config_v0 confv0;
@@ -152,12 +196,21 @@ int config_migrate_latest(const char* path)
         lseek(fd, 0, SEEK_SET);
         write(fd, &confv1, sizeof(confv1));
     }
-    else
+    else if (confv0.version > 3)
     {
         close(fd);
         return -1;
     }
 
+    if (confv0.version <= 1 || confv0.version > 0x7F)
+    {
+        config_migrate_v1_v2(fd);
+    }
+    if (confv0.version <= 2 || confv0.version > 0x7F)
+    {
+        config_migrate_v2_v3(fd);
+    }
+
     close(fd);
     return 0;
 }
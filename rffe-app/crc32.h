@@ -0,0 +1,38 @@
+/****************************************************************************
+ * rffe-app/crc32.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Update a CRC-32 (IEEE 802.3, same as zlib) with a new block
+ * of data. Start with crc = 0 and chain the returned values.
+ * @param crc: CRC of the previous blocks
+ * @return Updated CRC
+ */
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+
+#endif
@@ -0,0 +1,155 @@
+/****************************************************************************
+ * rffe-app/delta.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include "delta.h"
+
+enum delta_state
+{
+    DELTA_STATE_HEADER,
+    DELTA_STATE_DIFF,
+    DELTA_STATE_ZERO_RUN,
+    DELTA_STATE_EXTRA,
+};
+
+static uint32_t delta_le32(const uint8_t* buf)
+{
+    return buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+/*
+ * Move on to the next section of the current record, applying the seek
+ * once the diff and extra data are exhausted
+ */
+static void delta_next_section(struct delta_decoder* dec)
+{
+    if (dec->diff_left > 0)
+    {
+        dec->state = DELTA_STATE_DIFF;
+    }
+    else if (dec->extra_left > 0)
+    {
+        dec->state = DELTA_STATE_EXTRA;
+    }
+    else
+    {
+        dec->old_pos += dec->seek;
+        dec->hdr_fill = 0;
+        dec->state = DELTA_STATE_HEADER;
+    }
+}
+
+static int delta_put_diff(struct delta_decoder* dec, uint8_t diff)
+{
+    if (dec->old_pos < 0 || (uint32_t)dec->old_pos >= dec->old_len) return -2;
+
+    uint8_t byte = dec->read_old(dec->priv, dec->old_pos) + diff;
+
+    if (dec->put(dec->priv, byte) < 0) return -1;
+    dec->old_pos++;
+    dec->diff_left--;
+    return 0;
+}
+
+void delta_init(struct delta_decoder* dec, delta_put_t put, delta_read_old_t read_old,
+                uint32_t old_len, void* priv)
+{
+    dec->put = put;
+    dec->read_old = read_old;
+    dec->priv = priv;
+    dec->old_len = old_len;
+    dec->old_pos = 0;
+    dec->diff_left = 0;
+    dec->extra_left = 0;
+    dec->seek = 0;
+    dec->state = DELTA_STATE_HEADER;
+    dec->hdr_fill = 0;
+}
+
+int delta_decode(struct delta_decoder* dec, const uint8_t* in, size_t len)
+{
+    int ret;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t byte = in[i];
+
+        switch (dec->state)
+        {
+        case DELTA_STATE_HEADER:
+            dec->hdr[dec->hdr_fill++] = byte;
+            if (dec->hdr_fill == DELTA_RECORD_HEADER)
+            {
+                dec->diff_left = delta_le32(&dec->hdr[0]);
+                dec->extra_left = delta_le32(&dec->hdr[4]);
+                dec->seek = (int32_t)delta_le32(&dec->hdr[8]);
+                delta_next_section(dec);
+            }
+            break;
+
+        case DELTA_STATE_DIFF:
+            if (byte == 0)
+            {
+                dec->state = DELTA_STATE_ZERO_RUN;
+                break;
+            }
+            ret = delta_put_diff(dec, byte);
+            if (ret < 0) return ret;
+            if (dec->diff_left == 0) delta_next_section(dec);
+            break;
+
+        case DELTA_STATE_ZERO_RUN:
+        {
+            uint32_t run = (uint32_t)byte + 1;
+
+            if (run > dec->diff_left) return -2;
+
+            for (uint32_t j = 0; j < run; j++)
+            {
+                ret = delta_put_diff(dec, 0);
+                if (ret < 0) return ret;
+            }
+            if (dec->diff_left == 0)
+            {
+                delta_next_section(dec);
+            }
+            else
+            {
+                dec->state = DELTA_STATE_DIFF;
+            }
+        }
+            break;
+
+        case DELTA_STATE_EXTRA:
+            if (dec->put(dec->priv, byte) < 0) return -1;
+            if (--dec->extra_left == 0) delta_next_section(dec);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+int delta_done(const struct delta_decoder* dec)
+{
+    return dec->state == DELTA_STATE_HEADER && dec->hdr_fill == 0;
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+ * rffe-app/delta.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DELTA_H_
+#define DELTA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Streaming decoder for binary delta (bsdiff style) firmware patches.
+ *
+ * The new image is rebuilt from the running one (old image) and a
+ * sequence of records, each made of a 12 bytes header:
+ *
+ *   diff length (32 bits, little endian)
+ *   extra length (32 bits, little endian)
+ *   seek (32 bits signed, little endian)
+ *
+ * followed by the diff data and then by 'extra length' literal bytes.
+ * Each diff byte is added (modulo 256) to the old image byte at the
+ * current old position, which then advances. Since most diff bytes are
+ * zero, a 0x00 byte is followed by a count n and stands for n + 1 zero
+ * diff bytes (unchanged old bytes). 'diff length' counts the decoded
+ * bytes. After the extra bytes, 'seek' is added to the old position.
+ *
+ * Old image bytes are fetched through a callback, so the decoder itself
+ * only needs a few bytes of state.
+ */
+
+#define DELTA_RECORD_HEADER 12
+
+typedef int (*delta_put_t)(void* priv, uint8_t byte);
+typedef uint8_t (*delta_read_old_t)(void* priv, uint32_t offset);
+
+struct delta_decoder
+{
+    delta_put_t put;
+    delta_read_old_t read_old;
+    void* priv;
+    uint32_t old_len;
+    int32_t old_pos;
+    uint32_t diff_left;
+    uint32_t extra_left;
+    int32_t seek;
+    uint8_t state;
+    uint8_t hdr_fill;
+    uint8_t hdr[DELTA_RECORD_HEADER];
+};
+
+/**
+ * @brief Initialize a delta decoder
+ * @param put: Output callback, called once per decoded byte
+ * @param read_old: Returns the old image byte at a given offset
+ * @param old_len: Old image length, old offsets are checked against it
+ * @param priv: Private data passed to the callbacks
+ */
+void delta_init(struct delta_decoder* dec, delta_put_t put, delta_read_old_t read_old,
+                uint32_t old_len, void* priv);
+
+/**
+ * @brief Decode a chunk of patch data, records may span chunks
+ * @return 0 if success, a negative number if the patch is invalid or
+ * the put callback failed
+ */
+int delta_decode(struct delta_decoder* dec, const uint8_t* in, size_t len);
+
+/**
+ * @brief Check if the patch ended on a record boundary
+ * @return 1 if no record is partially decoded, 0 otherwise
+ */
+int delta_done(const struct delta_decoder* dec);
+
+#endif
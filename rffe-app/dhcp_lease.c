@@ -0,0 +1,381 @@
+/****************************************************************************
+ * rffe-app/dhcp_lease.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "dhcp_lease.h"
+#include "rffe_log.h"
+
+/*
+ * Below the SCPI, firmware update and temperature control threads
+ */
+#define DHCP_LEASE_PRIORITY      50
+#define DHCP_LEASE_STACK_SIZE    1536
+
+/*
+ * Retry delays (s), doubled after each failure
+ */
+#define DHCP_BACKOFF_MIN         2
+#define DHCP_BACKOFF_MAX         64
+
+/*
+ * Time without any lease (s) before falling back to the static
+ * configuration at boot. Requests keep being retried afterwards.
+ * dhcpc_request() may block for longer than that without a server, so
+ * the deadline is kept by its own short lived thread.
+ */
+#define DHCP_FALLBACK_TIMEOUT    30
+
+/*
+ * Request period (s) once on the static configuration. Each request
+ * takes the address down while it runs, so the board isn't probed for
+ * a server any more often than that.
+ */
+#define DHCP_FALLBACK_RETRY      600
+
+/*
+ * Used when the server doesn't send a lease time
+ */
+#define DHCP_DEFAULT_LEASE       3600
+
+static char* dhcp_netdev;
+static struct netifconfig* dhcp_conf;
+static struct netifconfig dhcp_static_conf;
+static void (*dhcp_configured)(void);
+
+static pthread_mutex_t dhcp_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Serializes the interface configuration (lease, fallback) between the
+ * lease and the deadline threads
+ */
+static pthread_mutex_t dhcp_if_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct dhcp_lease_info dhcp_info;
+
+/*
+ * Lease timers, in seconds since boot, protected by dhcp_lock
+ */
+static uint32_t dhcp_t1, dhcp_t2, dhcp_expiry;
+
+static const char* dhcp_state_names[] =
+{
+    "DISABLED",
+    "INIT",
+    "BOUND",
+    "RENEWING",
+    "REBINDING",
+    "FALLBACK",
+};
+
+static uint32_t dhcp_uptime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static enum dhcp_lease_state dhcp_get_state(void)
+{
+    enum dhcp_lease_state state;
+
+    pthread_mutex_lock(&dhcp_lock);
+    state = dhcp_info.state;
+    pthread_mutex_unlock(&dhcp_lock);
+    return state;
+}
+
+static void dhcp_set_state(enum dhcp_lease_state state)
+{
+    pthread_mutex_lock(&dhcp_lock);
+    dhcp_info.state = state;
+    pthread_mutex_unlock(&dhcp_lock);
+}
+
+static void dhcp_notify_configured(void)
+{
+    if (dhcp_configured != NULL)
+    {
+        dhcp_configured();
+        dhcp_configured = NULL;
+    }
+}
+
+static void dhcp_apply(const struct netifconfig* conf)
+{
+    netlib_set_ipv4addr(dhcp_netdev, &conf->ipaddr);
+    netlib_set_ipv4netmask(dhcp_netdev, &conf->netmask);
+    netlib_set_dripv4addr(dhcp_netdev, &conf->default_router);
+}
+
+static void dhcp_bind(const struct dhcpc_state* ds, int renewal)
+{
+    uint32_t now = dhcp_uptime();
+    uint32_t lease = ds->lease_time ? ds->lease_time : DHCP_DEFAULT_LEASE;
+    struct netifconfig conf = *dhcp_conf;
+
+    conf.ipaddr = ds->ipaddr;
+    if (ds->netmask.s_addr != 0) conf.netmask = ds->netmask;
+    if (ds->default_router.s_addr != 0) conf.default_router = ds->default_router;
+
+    /*
+     * dhcpc_request() leaves the interface at INADDR_ANY when it gets a
+     * lease, so the address is applied even when a renewal returns the
+     * same lease
+     */
+    dhcp_apply(&conf);
+    if (memcmp(&conf, dhcp_conf, sizeof(conf)) != 0)
+    {
+        *dhcp_conf = conf;
+        print_netconfig(dhcp_conf);
+    }
+
+    /*
+     * An infinite lease (0xFFFFFFFF) never reaches T1
+     */
+    if (lease > UINT32_MAX / 2 - now)
+    {
+        lease = UINT32_MAX / 2 - now;
+    }
+    pthread_mutex_lock(&dhcp_lock);
+    dhcp_t1 = now + lease / 2;
+    dhcp_t2 = now + lease - lease / 8;
+    dhcp_expiry = now + lease;
+    dhcp_info.state = DHCP_LEASE_BOUND;
+    dhcp_info.ipaddr = ds->ipaddr;
+    dhcp_info.server = ds->serverid;
+    dhcp_info.lease_time = ds->lease_time;
+    if (renewal) dhcp_info.renewals++;
+    pthread_mutex_unlock(&dhcp_lock);
+}
+
+static void dhcp_fallback(void)
+{
+    rffe_log_warn("DHCP: no lease, using the static configuration");
+
+    dhcp_apply(&dhcp_static_conf);
+    *dhcp_conf = dhcp_static_conf;
+    print_netconfig(dhcp_conf);
+
+    pthread_mutex_lock(&dhcp_lock);
+    dhcp_info.state = DHCP_LEASE_FALLBACK;
+    dhcp_info.ipaddr = dhcp_static_conf.ipaddr;
+    dhcp_info.server.s_addr = 0;
+    dhcp_info.lease_time = 0;
+    pthread_mutex_unlock(&dhcp_lock);
+}
+
+static void* dhcp_deadline_task(void* args)
+{
+    sleep(DHCP_FALLBACK_TIMEOUT);
+
+    pthread_mutex_lock(&dhcp_if_lock);
+    if (dhcp_get_state() == DHCP_LEASE_INIT)
+    {
+        dhcp_fallback();
+        dhcp_notify_configured();
+    }
+    pthread_mutex_unlock(&dhcp_if_lock);
+
+    return NULL;
+}
+
+static void* dhcp_lease_task(void* args)
+{
+    void* handle;
+    struct dhcpc_state ds;
+    uint32_t backoff = DHCP_BACKOFF_MIN;
+
+    handle = dhcpc_open(dhcp_netdev, dhcp_conf->mac, 6);
+    if (handle == NULL)
+    {
+        rffe_log_error("DHCP: couldn't open the client");
+        pthread_mutex_lock(&dhcp_if_lock);
+        dhcp_fallback();
+        dhcp_notify_configured();
+        pthread_mutex_unlock(&dhcp_if_lock);
+        return NULL;
+    }
+
+    while (1)
+    {
+        enum dhcp_lease_state state;
+        uint32_t t1, t2, expiry;
+        uint32_t now = dhcp_uptime();
+
+        pthread_mutex_lock(&dhcp_lock);
+        state = dhcp_info.state;
+        t1 = dhcp_t1;
+        t2 = dhcp_t2;
+        expiry = dhcp_expiry;
+        pthread_mutex_unlock(&dhcp_lock);
+
+        if (state == DHCP_LEASE_BOUND)
+        {
+            if (now < t1)
+            {
+                sleep(t1 - now);
+                continue;
+            }
+            dhcp_set_state(DHCP_LEASE_RENEWING);
+            backoff = DHCP_BACKOFF_MIN;
+            continue;
+        }
+
+        /*
+         * The NuttX client has no unicast renewal: renewing and
+         * rebinding both run a full request, only the timers differ.
+         * The request holds the interface at INADDR_ANY while it runs,
+         * so the board is briefly unreachable at each attempt.
+         */
+        if (dhcpc_request(handle, &ds) >= 0 && ds.ipaddr.s_addr != 0)
+        {
+            pthread_mutex_lock(&dhcp_if_lock);
+            dhcp_bind(&ds, state == DHCP_LEASE_RENEWING || state == DHCP_LEASE_REBINDING);
+            dhcp_notify_configured();
+            pthread_mutex_unlock(&dhcp_if_lock);
+            backoff = DHCP_BACKOFF_MIN;
+            continue;
+        }
+
+        pthread_mutex_lock(&dhcp_lock);
+        dhcp_info.failures++;
+        pthread_mutex_unlock(&dhcp_lock);
+
+        now = dhcp_uptime();
+
+        int expired = (state == DHCP_LEASE_RENEWING || state == DHCP_LEASE_REBINDING) &&
+            now >= expiry;
+
+        /*
+         * Put back the address the failed request took down: the lease
+         * still held, or the static one (possibly applied by the
+         * deadline thread while the request ran)
+         */
+        pthread_mutex_lock(&dhcp_if_lock);
+        if (expired)
+        {
+            rffe_log_warn("DHCP: lease expired");
+            dhcp_fallback();
+        }
+        else if (dhcp_get_state() != DHCP_LEASE_INIT)
+        {
+            dhcp_apply(dhcp_conf);
+        }
+        pthread_mutex_unlock(&dhcp_if_lock);
+
+        if (!expired && state == DHCP_LEASE_RENEWING && now >= t2)
+        {
+            dhcp_set_state(DHCP_LEASE_REBINDING);
+        }
+
+        /*
+         * Don't sleep past the lease expiry while still holding it
+         */
+        uint32_t delay = backoff;
+        if (dhcp_get_state() == DHCP_LEASE_FALLBACK)
+        {
+            delay = DHCP_FALLBACK_RETRY;
+        }
+        else if ((state == DHCP_LEASE_RENEWING || state == DHCP_LEASE_REBINDING) &&
+                 now < expiry && expiry - now < delay)
+        {
+            delay = expiry - now;
+        }
+        sleep(delay);
+
+        backoff *= 2;
+        if (backoff > DHCP_BACKOFF_MAX) backoff = DHCP_BACKOFF_MAX;
+    }
+
+    dhcpc_close(handle);
+    return NULL;
+}
+
+int dhcp_lease_start(char* netdev, struct netifconfig* conf, void (*configured)(void))
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct sched_param param;
+
+    dhcp_netdev = netdev;
+    dhcp_conf = conf;
+    dhcp_static_conf = *conf;
+    dhcp_configured = configured;
+    dhcp_info.state = DHCP_LEASE_INIT;
+    dhcp_info.ipaddr = conf->ipaddr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, DHCP_LEASE_STACK_SIZE);
+    param.sched_priority = DHCP_LEASE_PRIORITY;
+    pthread_attr_setschedparam(&attr, &param);
+
+    if (pthread_create(&thread, &attr, &dhcp_lease_task, NULL) != 0)
+    {
+        return -1;
+    }
+    pthread_detach(thread);
+
+    if (pthread_create(&thread, &attr, &dhcp_deadline_task, NULL) != 0)
+    {
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+void dhcp_lease_get_info(struct dhcp_lease_info* info)
+{
+    uint32_t now = dhcp_uptime();
+
+    uint32_t expiry;
+
+    pthread_mutex_lock(&dhcp_lock);
+    *info = dhcp_info;
+    expiry = dhcp_expiry;
+    pthread_mutex_unlock(&dhcp_lock);
+
+    if (info->state == DHCP_LEASE_DISABLED || info->state == DHCP_LEASE_INIT ||
+        info->state == DHCP_LEASE_FALLBACK || now >= expiry)
+    {
+        info->remaining = 0;
+    }
+    else
+    {
+        info->remaining = expiry - now;
+    }
+}
+
+const char* dhcp_lease_state_name(enum dhcp_lease_state state)
+{
+    return dhcp_state_names[state];
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+ * rffe-app/dhcp_lease.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DHCP_LEASE_H_
+#define DHCP_LEASE_H_
+
+#include <stdint.h>
+
+#include "netconfig.h"
+
+/*
+ * DHCP lease manager: a low priority thread that obtains the address,
+ * renews the lease at T1 (half the lease time) and T2 (7/8), retries
+ * with an exponential backoff and falls back to the static addresses
+ * stored in the FeRAM when no lease can be obtained or kept. Once on
+ * the static addresses a new lease is requested every 10 minutes.
+ *
+ * The NuttX client sets the interface address to INADDR_ANY while a
+ * request runs, so the board drops off the network for the duration
+ * of each renewal or retry. The address in use is put back when the
+ * request fails.
+ */
+
+enum dhcp_lease_state
+{
+    DHCP_LEASE_DISABLED,
+    DHCP_LEASE_INIT,
+    DHCP_LEASE_BOUND,
+    DHCP_LEASE_RENEWING,
+    DHCP_LEASE_REBINDING,
+    DHCP_LEASE_FALLBACK,
+};
+
+struct dhcp_lease_info
+{
+    enum dhcp_lease_state state;
+    struct in_addr ipaddr;
+    struct in_addr server;
+    uint32_t lease_time;
+    uint32_t remaining;
+    uint32_t renewals;
+    uint32_t failures;
+};
+
+/**
+ * @brief Start the lease manager thread
+ * @param netdev: Network interface, already up with the static config
+ * @param conf: Static configuration, used as fallback. It is updated
+ * with the configuration in use.
+ * @param configured: Called once, when the interface gets its first
+ * configuration (lease or fallback). May be NULL.
+ * @return 0 if success, a negative number otherwise
+ */
+int dhcp_lease_start(char* netdev, struct netifconfig* conf, void (*configured)(void));
+
+/**
+ * @brief Get a snapshot of the current lease state
+ */
+void dhcp_lease_get_info(struct dhcp_lease_info* info);
+
+/**
+ * @brief Name of a lease state ("DISABLED", "INIT", "BOUND", ...)
+ */
+const char* dhcp_lease_state_name(enum dhcp_lease_state state);
+
+#endif
@@ -0,0 +1,247 @@
+/****************************************************************************
+ * rffe-app/discovery.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <fixedmath.h>
+
+#include "netutils/netlib.h"
+
+#include "discovery.h"
+#include "config_file.h"
+#include "dhcp_lease.h"
+#include "git_version.h"
+#include "svc_loop.h"
+
+#define DISCOVERY_PRIORITY   50
+#define DISCOVERY_STACK_SIZE 1280
+
+/*
+ * Longest reply: the fixed fields take at most 139 characters (mac 17,
+ * ip 15, uptime 10, att/temp 8 each, tctrl 1, dhcp state 9 and the
+ * field names), plus the tag and the NUL terminator
+ */
+#define DISCOVERY_REPLY_SIZE (139 + sizeof(RFFE_GIT_TAG))
+
+static const char* cfg_file = "/dev/feram0";
+
+/*
+ * The reply is only formatted again when the uptime (seconds) changes,
+ * so a probe flood doesn't turn into FeRAM and SPI sensor traffic. The
+ * prefix (mac and tag) never changes and is formatted once. Only the
+ * thread serving the socket touches these.
+ */
+static char discovery_reply[DISCOVERY_REPLY_SIZE];
+static int discovery_prefix_len;
+static int discovery_reply_len;
+static time_t discovery_reply_time = -1;
+
+static float discovery_read_temp(const char* dev)
+{
+    b16_t temp = 0;
+    int fd = open(dev, O_RDONLY);
+
+    if (fd >= 0)
+    {
+        read(fd, &temp, sizeof(temp));
+        close(fd);
+    }
+    return b16tof(temp);
+}
+
+static int discovery_format(void)
+{
+    char* buf = discovery_reply;
+    size_t len = sizeof(discovery_reply);
+    char ip[INET_ADDRSTRLEN];
+    struct in_addr ipaddr;
+    struct timespec ts;
+    struct dhcp_lease_info lease;
+    b16_t att;
+    temp_ctrl_mode_t tctrl;
+    int n;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (ts.tv_sec == discovery_reply_time)
+    {
+        return discovery_reply_len;
+    }
+
+    if (discovery_prefix_len == 0)
+    {
+        uint8_t mac[6];
+
+        netlib_getmacaddr("eth0", mac);
+        discovery_prefix_len = snprintf(buf, len, "RFFE mac=%02x:%02x:%02x:%02x:%02x:%02x",
+                                        mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+
+    netlib_get_ipv4addr("eth0", &ipaddr);
+    inet_ntop(AF_INET, &ipaddr, ip, sizeof(ip));
+    dhcp_lease_get_info(&lease);
+    config_get_attenuation(cfg_file, &att);
+    config_get_temp_control_mode(cfg_file, &tctrl);
+
+    buf += discovery_prefix_len;
+    len -= discovery_prefix_len;
+    n = snprintf(buf, len,
+                 " ip=%s tag=%s uptime=%lu att=%.1f tctrl=%d temp_ac=%.1f temp_bd=%.1f dhcp=%s\n",
+                 ip, RFFE_GIT_TAG, (unsigned long)ts.tv_sec,
+                 b16tof(att), tctrl == TEMP_CTRL_AUTOMATIC,
+                 discovery_read_temp("/dev/temp_ac"),
+                 discovery_read_temp("/dev/temp_bd"),
+                 dhcp_lease_state_name(lease.state));
+    if (n < 0)
+    {
+        return n;
+    }
+
+    /*
+     * Keep the line terminated if a field is ever longer than expected
+     */
+    if ((size_t)n >= len)
+    {
+        n = len - 1;
+        buf[n - 1] = '\n';
+    }
+
+    discovery_reply_time = ts.tv_sec;
+    discovery_reply_len = discovery_prefix_len + n;
+    return discovery_reply_len;
+}
+
+static int discovery_open(void)
+{
+    struct sockaddr_in addr;
+    int sockfd;
+
+    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0)
+    {
+        perror("failed to open a socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(DISCOVERY_PORT);
+
+    if (bind(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        perror("failed to bind a socket");
+        close(sockfd);
+        return -1;
+    }
+
+    return sockfd;
+}
+
+/*
+ * Read one datagram and answer it if it is a probe
+ */
+static void discovery_handle(int sockfd, void* arg)
+{
+    struct sockaddr_in peer;
+    socklen_t peerlen;
+    char buf[sizeof(DISCOVERY_PROBE)];
+    int n;
+
+    peerlen = sizeof(peer);
+    n = recvfrom(sockfd, buf, sizeof(buf), 0, (struct sockaddr*)&peer, &peerlen);
+
+    if (n < (int)strlen(DISCOVERY_PROBE) ||
+        memcmp(buf, DISCOVERY_PROBE, strlen(DISCOVERY_PROBE)) != 0)
+    {
+        return;
+    }
+
+    /*
+     * Reply to the sender directly, even for broadcast probes
+     */
+    n = discovery_format();
+    if (n > 0)
+    {
+        sendto(sockfd, discovery_reply, n, 0, (struct sockaddr*)&peer, peerlen);
+    }
+}
+
+#ifdef CONFIG_EXAMPLES_RFFE_SHARED_SERVICES
+
+void start_discovery_server(void)
+{
+    int sockfd = discovery_open();
+
+    if (sockfd >= 0)
+    {
+        svc_loop_add(sockfd, discovery_handle, NULL);
+    }
+}
+
+#else
+
+static void* discovery_server(void* args)
+{
+    int sockfd = discovery_open();
+
+    if (sockfd < 0)
+    {
+        return NULL;
+    }
+
+    while (1)
+    {
+        discovery_handle(sockfd, NULL);
+    }
+
+    close(sockfd);
+    return NULL;
+}
+
+void start_discovery_server(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct sched_param param;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, DISCOVERY_STACK_SIZE);
+    param.sched_priority = DISCOVERY_PRIORITY;
+    pthread_attr_setschedparam(&attr, &param);
+    pthread_create(&thread, &attr, &discovery_server, NULL);
+    pthread_detach(thread);
+}
+
+#endif
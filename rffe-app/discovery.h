@@ -0,0 +1,41 @@
+/****************************************************************************
+ * rffe-app/discovery.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DISCOVERY_H_
+#define DISCOVERY_H_
+
+/*
+ * UDP discovery responder: answers any datagram starting with
+ * DISCOVERY_PROBE sent to DISCOVERY_PORT (usually as a broadcast) with
+ * a single text datagram describing the board, e.g.:
+ *
+ * RFFE mac=00:1a:b6:00:00:01 ip=10.0.18.35 tag=v1.2.0 uptime=3600
+ * att=12.5 tctrl=1 temp_ac=40.1 temp_bd=39.8 dhcp=BOUND
+ */
+
+#define DISCOVERY_PORT  9002
+#define DISCOVERY_PROBE "RFFE?"
+
+void start_discovery_server(void);
+
+#endif
@@ -38,13 +38,610 @@
 #include <string.h>
 #include <sys/boardctl.h>
 #include <sys/time.h>
+#include <time.h>
 
-static void* fw_update_server(void* args)
+#include "lzss.h"
+#include "delta.h"
+#include "crc32.h"
+#include "rffe_log.h"
+#include "svc_loop.h"
+
+#define FW_UPDATE_PROTOCOL_VERSION '7'
+#define FW_UPDATE_STACK_SIZE       1280
+#define FW_PAGE_SIZE               256
+#define FW_APP_START               0x10000
+#define FW_UPDATE_START            0x48000
+#define FW_UPDATE_END              0x80000
+#define FW_SECTOR_SIZE             0x8000
+#define FW_UPDATE_SECTORS          ((FW_UPDATE_END - FW_UPDATE_START) / FW_SECTOR_SIZE)
+#define FW_UPDATE_PAGES            ((FW_UPDATE_END - FW_UPDATE_START) / FW_PAGE_SIZE)
+
+/*
+ * Last staging page, holds the version, firmware type and magic word
+ * read by the bootloader (see bootloader/README.md)
+ */
+#define FW_TRAILER_ADDR            (FW_UPDATE_END - FW_PAGE_SIZE)
+#define FW_MAGIC_WORD              0xAAAAAAAA
+
+/*
+ * Streaming writes ('W') receive FW_RX_PAGES pages per recv() call and
+ * send a cumulative ack every FW_ACK_INTERVAL pages, so the host can
+ * keep a window of pages in flight instead of waiting for each one.
+ * Compressed ('Z') and delta ('D') writes send a progress ack ('p' +
+ * input bytes consumed) after every FW_ACK_INTERVAL pages of input, so
+ * the host windows their input the same way.
+ */
+#define FW_RX_PAGES     4
+#define FW_ACK_INTERVAL 4
+
+static uint8_t fw_rx_buf[FW_RX_PAGES * FW_PAGE_SIZE];
+
+static uint32_t get_le32(const uint8_t* buf)
 {
-    socklen_t clilen;
-    struct sockaddr_in serv_addr, cli_addr;
+    return buf[0] | buf[1] << 8 | buf[2] << 16 | buf[3] << 24;
+}
+
+static void put_le32(uint8_t* buf, uint32_t val)
+{
+    buf[0] = val & 0xFF;
+    buf[1] = (val >> 8) & 0xFF;
+    buf[2] = (val >> 16) & 0xFF;
+    buf[3] = (val >> 24) & 0xFF;
+}
+
+/*
+ * Update session, started by the 'e' command.
+ *
+ * Staging sectors are erased on demand: each one is erased right
+ * before its first page is programmed. Meanwhile the EMAC keeps
+ * receiving the pages in flight through DMA, so the erase overlaps
+ * with the network transfer instead of stalling it up front.
+ *
+ * The image header ('h' command) gives the expected size, CRC-32 and
+ * version. The CRC is accumulated as pages are programmed in order,
+ * and the trailer with the magic word is only written if everything
+ * matches.
+ *
+ * The session outlives the TCP connection: every page programmed and
+ * read back correctly is marked in a bitmap, which the host can query
+ * ('q' command) to resume an interrupted upload from the first missing
+ * page. Transfer statistics are reported by the 's' command.
+ */
+struct fw_stats
+{
+    uint32_t bytes_rx;
+    uint32_t pages_written;
+    uint32_t sectors_erased;
+    uint32_t erase_us;
+    uint32_t program_us;
+    uint32_t start_us;
+    uint32_t last_us;
+};
+
+struct fw_session
+{
+    uint8_t erased_sectors;
+    uint8_t has_header;
+    uint8_t in_order;
+    uint8_t version[3];
+    uint8_t fw_type;
+    uint32_t size;
+    uint32_t crc_expected;
+    uint32_t crc;
+    uint32_t crc_len;
+    uint8_t written[FW_UPDATE_PAGES / 8];
+    struct fw_stats stats;
+};
+
+static struct fw_session fw_session;
+
+static uint32_t fw_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void fw_session_start(void)
+{
+    memset(&fw_session, 0, sizeof(fw_session));
+    fw_session.in_order = 1;
+    fw_session.stats.start_us = fw_time_us();
+    fw_session.stats.last_us = fw_session.stats.start_us;
+}
+
+/*
+ * recv() wrapper accounting the bytes received in this session
+ */
+static int fw_recv(int sockfd, void* buf, size_t len)
+{
+    int n = recv(sockfd, buf, len, MSG_WAITALL);
+
+    if (n > 0)
+    {
+        fw_session.stats.bytes_rx += n;
+        fw_session.stats.last_us = fw_time_us();
+    }
+    return n;
+}
+
+static void fw_session_account(uint32_t addr, const uint8_t* data)
+{
+    uint32_t offset = addr - FW_UPDATE_START;
+
+    if (!fw_session.has_header || offset >= fw_session.size)
+    {
+        return;
+    }
+
+    if (offset != fw_session.crc_len)
+    {
+        fw_session.in_order = 0;
+        return;
+    }
+
+    uint32_t len = fw_session.size - offset;
+    if (len > FW_PAGE_SIZE) len = FW_PAGE_SIZE;
+
+    fw_session.crc = crc32_update(fw_session.crc, data, len);
+    fw_session.crc_len += len;
+}
+
+/*
+ * The magic word may only be armed when the staged image is complete
+ * and matches the header sent by the host. If the trailer carries the
+ * application length and CRC-32 checked by the bootloader at boot,
+ * they must match too.
+ */
+static int fw_session_verify_trailer(const uint8_t* data)
+{
+    const uint8_t* record = &data[FW_PAGE_SIZE - 16];
+    const uint8_t* info = &data[FW_PAGE_SIZE - 8];
+
+    if (get_le32(&record[0]) != 0xFFFFFFFF &&
+        (get_le32(&record[0]) != fw_session.size ||
+         get_le32(&record[4]) != fw_session.crc_expected))
+    {
+        return 0;
+    }
+
+    return fw_session.has_header && fw_session.in_order &&
+        fw_session.crc_len == fw_session.size &&
+        fw_session.crc == fw_session.crc_expected &&
+        memcmp(info, fw_session.version, 3) == 0 &&
+        info[3] == fw_session.fw_type;
+}
+
+#ifdef CONFIG_ARCH_CHIP_LPC17XX_40XX
+/*
+ * IAP blank check, the same ROM call as bootloader/src/lpc17_iap.c.
+ * It only reads the flash, so it runs with interrupts enabled. Flash
+ * sectors above 0x10000 are 32 KiB each, starting at sector 16.
+ */
+#define FW_IAP_ENTRY        0x1FFF1FF1
+#define FW_IAP_BLANK_CHECK  53
+#define FW_IAP_SUCCESS      0
+#define FW_IAP_SECTOR(addr) (16 + ((addr) - 0x10000) / FW_SECTOR_SIZE)
+
+static int fw_sector_blank(int sector)
+{
+    void (*iap_entry)(uint32_t*, uint32_t*) = (void*)FW_IAP_ENTRY;
+    uint32_t iap_sector = FW_IAP_SECTOR(FW_UPDATE_START) + sector;
+    uint32_t inout[5] = {FW_IAP_BLANK_CHECK, iap_sector, iap_sector};
+
+    iap_entry(inout, inout);
+    return inout[0] == FW_IAP_SUCCESS;
+}
+#else
+static int fw_sector_blank(int sector)
+{
+    const uint32_t* word = (const uint32_t*)(uintptr_t)(FW_UPDATE_START + sector * FW_SECTOR_SIZE);
+
+    for (int i = 0; i < FW_SECTOR_SIZE / 4; i++)
+    {
+        if (word[i] != 0xFFFFFFFF)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+#endif
+
+/*
+ * Program one page of the staging area, erasing its sector first if
+ * it wasn't erased yet in this session and isn't blank already
+ */
+static int fw_program_page(uint32_t addr, const uint8_t* data)
+{
+    int sector = (addr - FW_UPDATE_START) / FW_SECTOR_SIZE;
+
+    if (addr == FW_TRAILER_ADDR &&
+        get_le32(&data[FW_PAGE_SIZE - 4]) == FW_MAGIC_WORD &&
+        !fw_session_verify_trailer(data))
+    {
+        rffe_log_error("Firmware update server: image verification failed, not arming");
+        return -1;
+    }
+
+    if (!(fw_session.erased_sectors & (1 << sector)))
+    {
+        if (!fw_sector_blank(sector))
+        {
+            uint32_t t0 = fw_time_us();
+
+            if (up_progmem_eraseblock(sector) < 0)
+            {
+                return -1;
+            }
+            fw_session.stats.erase_us += fw_time_us() - t0;
+            fw_session.stats.sectors_erased++;
+        }
+        fw_session.erased_sectors |= 1 << sector;
+    }
+
+    uint32_t t0 = fw_time_us();
+
+    if (up_progmem_write(addr, data, FW_PAGE_SIZE) < 0 ||
+        memcmp((const void*)(uintptr_t)addr, data, FW_PAGE_SIZE) != 0)
+    {
+        return -1;
+    }
+    fw_session.stats.program_us += fw_time_us() - t0;
+    fw_session.stats.pages_written++;
+
+    uint32_t page = (addr - FW_UPDATE_START) / FW_PAGE_SIZE;
+    fw_session.written[page / 8] |= 1 << (page % 8);
+
+    fw_session_account(addr, data);
+    return 0;
+}
+
+static uint32_t fw_first_missing_page(void)
+{
+    uint32_t page;
+
+    for (page = 0; page < FW_UPDATE_PAGES; page++)
+    {
+        if (!(fw_session.written[page / 8] & (1 << (page % 8))))
+        {
+            break;
+        }
+    }
+    return page;
+}
+
+/*
+ * Page query: '1', first missing page index (32 bits, little endian)
+ * and the written pages bitmap (page 0 is bit 0 of the first byte)
+ */
+static void fw_send_pages(int sockfd)
+{
+    uint8_t hdr[5];
+
+    hdr[0] = '1';
+    put_le32(&hdr[1], fw_first_missing_page());
+    write(sockfd, hdr, sizeof(hdr));
+    write(sockfd, fw_session.written, sizeof(fw_session.written));
+}
+
+/*
+ * Session status: '1' followed by 32 bits little endian words: bytes
+ * received, pages written, sectors erased, time spent erasing (us),
+ * time spent programming (us), session time up to the last received
+ * byte (us) and the effective throughput (bytes/s)
+ */
+static void fw_send_status(int sockfd)
+{
+    const struct fw_stats* st = &fw_session.stats;
+    uint32_t elapsed = st->last_us - st->start_us;
+    uint32_t throughput = elapsed ? (uint64_t)st->bytes_rx * 1000000 / elapsed : 0;
+    uint8_t ans[1 + 7 * 4];
+
+    ans[0] = '1';
+    put_le32(&ans[1], st->bytes_rx);
+    put_le32(&ans[5], st->pages_written);
+    put_le32(&ans[9], st->sectors_erased);
+    put_le32(&ans[13], st->erase_us);
+    put_le32(&ans[17], st->program_us);
+    put_le32(&ans[21], elapsed);
+    put_le32(&ans[25], throughput);
+    write(sockfd, ans, sizeof(ans));
+}
+
+/*
+ * Cumulative ack: status byte ('1' ok / '0' error) followed by the
+ * number of pages committed to flash so far (32 bits, little endian)
+ */
+static void fw_stream_ack(int sockfd, char status, uint32_t pages)
+{
+    uint8_t ack[5];
+
+    ack[0] = status;
+    put_le32(&ack[1], pages);
+    write(sockfd, ack, sizeof(ack));
+}
+
+/*
+ * Streaming write: 'W' <start address (4 bytes)> <page count (4 bytes)>
+ * followed by page count * 256 bytes of data, sent without waiting for
+ * the acks. On any error a '0' ack is sent and a negative number is
+ * returned, the connection must then be closed since the rest of the
+ * stream can't be trusted.
+ */
+static int fw_update_stream(int sockfd)
+{
+    uint8_t hdr[8];
+    uint32_t start_addr, npages, done = 0;
+    int n;
+
+    n = fw_recv(sockfd, hdr, sizeof(hdr));
+    if (n != sizeof(hdr)) return -1;
+
+    start_addr = get_le32(&hdr[0]);
+    npages = get_le32(&hdr[4]);
+
+    if ((start_addr % FW_PAGE_SIZE) != 0 || start_addr < FW_UPDATE_START ||
+        start_addr >= FW_UPDATE_END ||
+        npages > (FW_UPDATE_END - start_addr) / FW_PAGE_SIZE)
+    {
+        fw_stream_ack(sockfd, '0', 0);
+        return -1;
+    }
+
+    while (done < npages)
+    {
+        uint32_t chunk = npages - done;
+        if (chunk > FW_RX_PAGES) chunk = FW_RX_PAGES;
+
+        n = fw_recv(sockfd, fw_rx_buf, chunk * FW_PAGE_SIZE);
+        if (n != chunk * FW_PAGE_SIZE) return -1;
+
+        for (uint32_t i = 0; i < chunk; i++, done++)
+        {
+            if (fw_program_page(start_addr + done * FW_PAGE_SIZE,
+                                &fw_rx_buf[i * FW_PAGE_SIZE]) < 0)
+            {
+                fw_stream_ack(sockfd, '0', done);
+                return -1;
+            }
+
+            if ((done + 1) % FW_ACK_INTERVAL == 0 || done + 1 == npages)
+            {
+                fw_stream_ack(sockfd, '1', done + 1);
+            }
+        }
+    }
+
+    if (npages == 0)
+    {
+        fw_stream_ack(sockfd, '1', 0);
+    }
+
+    return 0;
+}
+
+/*
+ * Decompressed or patched output is assembled one flash page at a
+ * time. LZSS back-references to bytes of previous pages are read
+ * straight from flash, so no history window is kept in RAM.
+ */
+struct fw_page_sink
+{
+    uint32_t start_addr;
+    uint32_t max_len;
+    uint32_t pos;
+    uint32_t pages;
+};
+
+static uint8_t fw_page_buf[FW_PAGE_SIZE];
+
+static void fw_sink_init(struct fw_page_sink* sink, uint32_t start_addr, uint32_t max_len)
+{
+    sink->start_addr = start_addr;
+    sink->max_len = max_len;
+    sink->pos = 0;
+    sink->pages = 0;
+}
+
+static int fw_sink_put(void* priv, uint8_t byte)
+{
+    struct fw_page_sink* sink = priv;
+
+    if (sink->pos >= sink->max_len) return -1;
+
+    fw_page_buf[sink->pos % FW_PAGE_SIZE] = byte;
+    sink->pos++;
+
+    if ((sink->pos % FW_PAGE_SIZE) == 0)
+    {
+        if (fw_program_page(sink->start_addr + sink->pos - FW_PAGE_SIZE,
+                            fw_page_buf) < 0)
+        {
+            return -1;
+        }
+        sink->pages++;
+    }
+
+    return 0;
+}
+
+static uint8_t fw_sink_peek(void* priv, uint32_t distance)
+{
+    struct fw_page_sink* sink = priv;
+    uint32_t page_start = sink->pos - (sink->pos % FW_PAGE_SIZE);
+    uint32_t offset = sink->pos - distance;
+
+    if (offset >= page_start)
+    {
+        return fw_page_buf[offset - page_start];
+    }
+
+    return *(const uint8_t*)(uintptr_t)(sink->start_addr + offset);
+}
+
+/*
+ * Pad and write the last partial page, the whole output must have been
+ * produced
+ */
+static int fw_sink_finish(struct fw_page_sink* sink)
+{
+    if ((sink->pos % FW_PAGE_SIZE) != 0 && sink->pos == sink->max_len)
+    {
+        uint32_t fill = sink->pos % FW_PAGE_SIZE;
+        memset(&fw_page_buf[fill], 0xFF, FW_PAGE_SIZE - fill);
+        if (fw_program_page(sink->start_addr + sink->pos - fill, fw_page_buf) < 0)
+        {
+            return -1;
+        }
+        sink->pages++;
+    }
+
+    return sink->pos == sink->max_len ? 0 : -1;
+}
+
+/*
+ * Compressed write: 'Z' <start address (4 bytes)> <decompressed length
+ * (4 bytes)> <compressed length (4 bytes)> followed by the LZSS stream
+ * (see lzss.h). Progress acks ('p' + stream bytes consumed) are sent
+ * every FW_ACK_INTERVAL pages of stream, and a final ack (status + pages
+ * committed) at the end, or as soon as an error is found.
+ */
+static int fw_update_compressed(int sockfd)
+{
+    uint8_t hdr[12];
+    uint32_t start_addr, out_len, in_len, done = 0;
+    struct fw_page_sink sink;
+    struct lzss_decoder dec;
+    int n;
+
+    n = fw_recv(sockfd, hdr, sizeof(hdr));
+    if (n != sizeof(hdr)) return -1;
+
+    start_addr = get_le32(&hdr[0]);
+    out_len = get_le32(&hdr[4]);
+    in_len = get_le32(&hdr[8]);
+
+    if ((start_addr % FW_PAGE_SIZE) != 0 || start_addr < FW_UPDATE_START ||
+        start_addr >= FW_UPDATE_END || out_len > FW_UPDATE_END - start_addr)
+    {
+        fw_stream_ack(sockfd, '0', 0);
+        return -1;
+    }
+
+    fw_sink_init(&sink, start_addr, out_len);
+    lzss_init(&dec, fw_sink_put, fw_sink_peek, &sink);
+
+    while (done < in_len)
+    {
+        uint32_t chunk = in_len - done;
+        if (chunk > sizeof(fw_rx_buf)) chunk = sizeof(fw_rx_buf);
+
+        n = fw_recv(sockfd, fw_rx_buf, chunk);
+        if (n != chunk) return -1;
+        done += chunk;
+
+        if (lzss_decode(&dec, fw_rx_buf, chunk) < 0)
+        {
+            fw_stream_ack(sockfd, '0', sink.pages);
+            return -1;
+        }
+
+        if ((done % (FW_ACK_INTERVAL * FW_PAGE_SIZE)) == 0 && done < in_len)
+        {
+            fw_stream_ack(sockfd, 'p', done);
+        }
+    }
+
+    if (fw_sink_finish(&sink) < 0)
+    {
+        fw_stream_ack(sockfd, '0', sink.pages);
+        return -1;
+    }
+
+    fw_stream_ack(sockfd, '1', sink.pages);
+    return 0;
+}
+
+static uint8_t fw_read_old(void* priv, uint32_t offset)
+{
+    return *(const uint8_t*)(uintptr_t)(FW_APP_START + offset);
+}
+
+/*
+ * Delta write: 'D' <start address (4 bytes)> <new image length (4
+ * bytes)> <patch length (4 bytes)> <old image length (4 bytes)> <old
+ * image CRC-32 (4 bytes)> followed by the patch (see delta.h). The new
+ * image is rebuilt from the running application at FW_APP_START, the
+ * patch is refused if it was made against a different image. Progress
+ * acks are sent like for compressed writes, and a final ack (status +
+ * pages committed) at the end, or as soon as an error is found.
+ */
+static int fw_update_delta(int sockfd)
+{
+    uint8_t hdr[20];
+    uint32_t start_addr, out_len, in_len, old_len, old_crc, done = 0;
+    struct fw_page_sink sink;
+    struct delta_decoder dec;
+    int n;
+
+    n = fw_recv(sockfd, hdr, sizeof(hdr));
+    if (n != sizeof(hdr)) return -1;
+
+    start_addr = get_le32(&hdr[0]);
+    out_len = get_le32(&hdr[4]);
+    in_len = get_le32(&hdr[8]);
+    old_len = get_le32(&hdr[12]);
+    old_crc = get_le32(&hdr[16]);
+
+    if ((start_addr % FW_PAGE_SIZE) != 0 || start_addr < FW_UPDATE_START ||
+        start_addr >= FW_UPDATE_END || out_len > FW_UPDATE_END - start_addr ||
+        old_len > FW_UPDATE_START - FW_APP_START ||
+        crc32_update(0, (const void*)(uintptr_t)FW_APP_START, old_len) != old_crc)
+    {
+        fw_stream_ack(sockfd, '0', 0);
+        return -1;
+    }
+
+    fw_sink_init(&sink, start_addr, out_len);
+    delta_init(&dec, fw_sink_put, fw_read_old, old_len, &sink);
+
+    while (done < in_len)
+    {
+        uint32_t chunk = in_len - done;
+        if (chunk > sizeof(fw_rx_buf)) chunk = sizeof(fw_rx_buf);
+
+        n = fw_recv(sockfd, fw_rx_buf, chunk);
+        if (n != chunk) return -1;
+        done += chunk;
+
+        if (delta_decode(&dec, fw_rx_buf, chunk) < 0)
+        {
+            fw_stream_ack(sockfd, '0', sink.pages);
+            return -1;
+        }
+
+        if ((done % (FW_ACK_INTERVAL * FW_PAGE_SIZE)) == 0 && done < in_len)
+        {
+            fw_stream_ack(sockfd, 'p', done);
+        }
+    }
+
+    if (!delta_done(&dec) || fw_sink_finish(&sink) < 0)
+    {
+        fw_stream_ack(sockfd, '0', sink.pages);
+        return -1;
+    }
+
+    fw_stream_ack(sockfd, '1', sink.pages);
+    return 0;
+}
+
+static int fw_update_listen(void)
+{
+    struct sockaddr_in serv_addr;
     int sockfd, ret;
-    uint8_t tcp_buf[256];
 
     /*
      * Open a socket
@@ -54,7 +651,7 @@ static void* fw_update_server(void* args)
     if (sockfd < 0)
     {
         perror("failed to open a socket");
-        return NULL;
+        return -1;
     }
 
     memset(&serv_addr, 0, sizeof(serv_addr));
@@ -67,101 +664,292 @@ static void* fw_update_server(void* args)
     if (ret < 0)
     {
         perror("failed to bind a socket");
-        return NULL;
+        close(sockfd);
+        return -1;
     }
 
     ret = listen(sockfd, 4);
     if (ret < 0)
     {
         perror("failed to listen to a socket");
-        return NULL;
+        close(sockfd);
+        return -1;
+    }
+
+    return sockfd;
+}
+
+/*
+ * Serve the commands of a connected client until it disconnects, the
+ * socket is closed by the caller
+ */
+static void fw_update_session(int newsockfd)
+{
+    uint8_t* tcp_buf = fw_rx_buf;
+    struct timeval tv;
+
+    /*
+     * Receive timeout: 30s. A session that can't time out would keep
+     * the server (or the session slot) forever on a dead client.
+     */
+    tv.tv_sec  = 30;
+    tv.tv_usec = 0;
+    if (setsockopt(newsockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(struct timeval)) < 0)
+    {
+        rffe_log_error("Firmware update server: failed to set the receive timeout");
+        return;
     }
 
     while (1)
     {
-        clilen = sizeof(cli_addr);
-        int newsockfd = accept(sockfd, (struct sockaddr *) &cli_addr, &clilen);
+        int n = recv(newsockfd, tcp_buf, 1, MSG_WAITALL);
 
-        if (newsockfd > 0)
+        if (n == 0)
         {
-            printf("Firmware update server: new connection\n");
+            rffe_log_info("Firmware update server: connection closed");
+            break;
+        }
+        else if (n < 0)
+        {
+            rffe_log_warn("Firmware update server: connection error (%d)", n);
+            break;
         }
-        else continue;
 
-        struct timeval tv;
+        switch (tcp_buf[0])
+        {
+        case 'e':
+            /*
+             * Start a new update session: sectors 23 to 29
+             * (0x00048000 - 0x0007FFFF) are erased on demand. A
+             * host resuming an upload skips this command.
+             */
+            fw_session_start();
+            write(newsockfd, "1", 1);
+            break;
 
-        /*
-         * Receive timeout: 30s
-         */
-        tv.tv_sec  = 30;
-        tv.tv_usec = 0;
-        ret = setsockopt(newsockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(struct timeval));
+        case 'h':
+            /*
+             * Image header: size (4 bytes), CRC-32 (4 bytes),
+             * version (3 bytes) and firmware type (1 byte)
+             */
+            n = fw_recv(newsockfd, tcp_buf, 12);
+            if (n != 12) break;
 
-        while (1)
-        {
-            int n = recv(newsockfd, tcp_buf, 1, MSG_WAITALL);
+            fw_session.size = get_le32(&tcp_buf[0]);
+            fw_session.crc_expected = get_le32(&tcp_buf[4]);
+            memcpy(fw_session.version, &tcp_buf[8], 3);
+            fw_session.fw_type = tcp_buf[11];
 
-            if (n == 0)
+            if (fw_session.size <= FW_TRAILER_ADDR - FW_UPDATE_START &&
+                fw_session.crc_len == 0)
             {
-                printf("Firmware update server: connection closed\n");
-                break;
+                fw_session.has_header = 1;
+                write(newsockfd, "1", 1);
             }
-            else if (n < 0)
+            else
             {
-                printf("Firmware update server: connection error (%d)\n", n);
-                break;
+                write(newsockfd, "0", 1);
             }
+            break;
 
-            switch (tcp_buf[0])
-            {
-            case 'e':
-                /*
-                 * Erase sectors 23 to 29 (0x00048000 - 0x0007FFFF)
-                 */
-                for (int i = 0; i < 7; i++)
-                {
-                    up_progmem_eraseblock(i);
-                }
-                write(newsockfd, "1", 1);
-                break;
-
-            case 'w':
-            {
-                n = recv(newsockfd, tcp_buf, 4, MSG_WAITALL);
-                if (n != 4) break;
+        case 'w':
+        {
+            n = fw_recv(newsockfd, tcp_buf, 4);
+            if (n != 4) break;
 
-                uint32_t start_addr = tcp_buf[0] | tcp_buf[1] << 8 |
-                    tcp_buf[2] << 16 | tcp_buf[3] << 24;
+            uint32_t start_addr = get_le32(tcp_buf);
 
-                n = recv(newsockfd, tcp_buf, 256, MSG_WAITALL);
-                if (n != 256) break;
+            n = fw_recv(newsockfd, tcp_buf, 256);
+            if (n != 256) break;
 
-                if (start_addr >= 0x48000 && start_addr <= (0x80000 - 256))
+            if (start_addr >= FW_UPDATE_START && start_addr <= (FW_UPDATE_END - 256) &&
+                (start_addr % FW_PAGE_SIZE) == 0)
+            {
+                if (fw_program_page(start_addr, tcp_buf) < 0)
                 {
-                    up_progmem_write(start_addr, tcp_buf, 256);
-                    write(newsockfd, "1", 1);
+                    write(newsockfd, "0", 1);
                 }
                 else
                 {
-                    write(newsockfd, "0", 1);
+                    write(newsockfd, "1", 1);
                 }
             }
-                break;
-
-            case 'r':
-                boardctl(BOARDIOC_RESET, 0);
-                break;
-
-            default:
-                printf("Firmware update server: invalid command '%c'\n", tcp_buf[0]);
+            else
+            {
                 write(newsockfd, "0", 1);
-                break;
             }
         }
+            break;
+
+        case 'W':
+            n = fw_update_stream(newsockfd);
+            break;
+
+        case 'Z':
+            n = fw_update_compressed(newsockfd);
+            break;
+
+        case 'D':
+            n = fw_update_delta(newsockfd);
+            break;
+
+        case 'q':
+            fw_send_pages(newsockfd);
+            break;
+
+        case 's':
+            fw_send_status(newsockfd);
+            break;
+
+        case 'v':
+        {
+            char version = FW_UPDATE_PROTOCOL_VERSION;
+            write(newsockfd, &version, 1);
+        }
+            break;
+
+        case 'r':
+            boardctl(BOARDIOC_RESET, 0);
+            break;
+
+        default:
+            rffe_log_warn("Firmware update server: invalid command '%c'", tcp_buf[0]);
+            write(newsockfd, "0", 1);
+            break;
+        }
+
+        if (n < 0)
+        {
+            rffe_log_warn("Firmware update server: command aborted");
+            break;
+        }
+    }
+}
+
+#ifdef CONFIG_EXAMPLES_RFFE_SHARED_SERVICES
+
+/*
+ * The listener runs on the shared service loop, a thread is only
+ * started for the duration of an update session. The session state is
+ * global, so there is one session at a time: a new connection (a host
+ * reconnecting after a dropped connection) takes over, the stale
+ * session is shut down instead of waiting for its receive timeout and
+ * the same thread serves the new connection.
+ */
+static pthread_mutex_t fw_session_lock = PTHREAD_MUTEX_INITIALIZER;
+static int fw_session_fd = -1;
+static int fw_pending_fd = -1;
+
+static void* fw_update_session_thread(void* args)
+{
+    int sockfd = (int)(intptr_t)args;
+
+    while (sockfd >= 0)
+    {
+        fw_update_session(sockfd);
+
+        pthread_mutex_lock(&fw_session_lock);
+        close(sockfd);
+        sockfd = fw_pending_fd;
+        fw_pending_fd = -1;
+        fw_session_fd = sockfd;
+        pthread_mutex_unlock(&fw_session_lock);
+
+        if (sockfd >= 0)
+        {
+            rffe_log_info("Firmware update server: connection taken over");
+        }
+    }
+
+    return NULL;
+}
+
+static void fw_update_accept(int sockfd, void* arg)
+{
+    struct sockaddr_in cli_addr;
+    socklen_t clilen = sizeof(cli_addr);
+    pthread_t thread;
+    pthread_attr_t attr;
 
+    int newsockfd = accept(sockfd, (struct sockaddr *) &cli_addr, &clilen);
+
+    if (newsockfd < 0)
+    {
+        return;
+    }
+
+    rffe_log_info("Firmware update server: new connection");
+
+    pthread_mutex_lock(&fw_session_lock);
+    if (fw_session_fd >= 0)
+    {
         /*
-         * Close the socket
+         * Wake the running session up from its recv(), it hands its
+         * thread over to this connection when it ends. Only the last
+         * connection waits.
          */
+        if (fw_pending_fd >= 0)
+        {
+            close(fw_pending_fd);
+        }
+        fw_pending_fd = newsockfd;
+        shutdown(fw_session_fd, SHUT_RDWR);
+        pthread_mutex_unlock(&fw_session_lock);
+        return;
+    }
+    fw_session_fd = newsockfd;
+    pthread_mutex_unlock(&fw_session_lock);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, FW_UPDATE_STACK_SIZE);
+    if (pthread_create(&thread, &attr, &fw_update_session_thread,
+                       (void*)(intptr_t)newsockfd) != 0)
+    {
+        rffe_log_error("Firmware update server: failed to start the session");
+        pthread_mutex_lock(&fw_session_lock);
+        close(newsockfd);
+        fw_session_fd = -1;
+        pthread_mutex_unlock(&fw_session_lock);
+        return;
+    }
+    pthread_detach(thread);
+}
+
+void start_fw_update_server(void)
+{
+    int sockfd = fw_update_listen();
+
+    if (sockfd >= 0)
+    {
+        svc_loop_add(sockfd, fw_update_accept, NULL);
+    }
+}
+
+#else
+
+static void* fw_update_server(void* args)
+{
+    socklen_t clilen;
+    struct sockaddr_in cli_addr;
+    int sockfd = fw_update_listen();
+
+    if (sockfd < 0)
+    {
+        return NULL;
+    }
+
+    while (1)
+    {
+        clilen = sizeof(cli_addr);
+        int newsockfd = accept(sockfd, (struct sockaddr *) &cli_addr, &clilen);
+
+        if (newsockfd > 0)
+        {
+            rffe_log_info("Firmware update server: new connection");
+        }
+        else continue;
+
+        fw_update_session(newsockfd);
         close(newsockfd);
     }
     return NULL;
@@ -173,7 +961,9 @@ void start_fw_update_server(void)
     pthread_attr_t attr;
 
     pthread_attr_init(&attr);
-    pthread_attr_setstacksize(&attr, 1280);
+    pthread_attr_setstacksize(&attr, FW_UPDATE_STACK_SIZE);
     pthread_create(&thread, &attr, &fw_update_server, NULL);
     pthread_detach(thread);
 }
+
+#endif
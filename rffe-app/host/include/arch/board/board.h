@@ -0,0 +1,37 @@
+/****************************************************************************
+ * rffe-app/host/include/arch/board/board.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_ARCH_BOARD_BOARD_H
+#define __HOST_ARCH_BOARD_BOARD_H
+
+#include <sys/boardctl.h>
+
+/*
+ * Attenuator part of rffe-board/include/board.h
+ */
+#define BOARD_ATT_CHANNELS    4
+#define BOARD_ATT_BITS        6
+
+#define BOARDIOC_ATT_SETCODES (BOARDIOC_USER + 0)
+
+#endif
@@ -0,0 +1,41 @@
+/****************************************************************************
+ * rffe-app/host/include/fixedmath.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_FIXEDMATH_H
+#define __HOST_FIXEDMATH_H
+
+/*
+ * Subset of the NuttX fixed point helpers used by the application
+ */
+
+#include <stdint.h>
+
+typedef int32_t b16_t;
+
+#define b16ONE    0x00010000
+#define itob16(i) ((b16_t)(i) << 16)
+#define b16toi(b) ((b) >> 16)
+#define ftob16(f) ((b16_t)((f) * (double)b16ONE))
+#define b16tof(b) ((float)(b) / (float)b16ONE)
+
+#endif
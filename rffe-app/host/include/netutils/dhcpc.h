@@ -0,0 +1,47 @@
+/****************************************************************************
+ * rffe-app/host/include/netutils/dhcpc.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_NETUTILS_DHCPC_H
+#define __HOST_NETUTILS_DHCPC_H
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+struct dhcpc_state
+{
+    struct in_addr serverid;
+    struct in_addr ipaddr;
+    struct in_addr netmask;
+    struct in_addr dnsaddr;
+    struct in_addr default_router;
+    uint32_t lease_time;
+};
+
+/*
+ * No DHCP client on the host, dhcpc_open() always fails
+ */
+void* dhcpc_open(const char* interface, const void* mac_addr, int mac_len);
+int dhcpc_request(void* handle, struct dhcpc_state* presult);
+void dhcpc_close(void* handle);
+
+#endif
@@ -0,0 +1,43 @@
+/****************************************************************************
+ * rffe-app/host/include/netutils/netlib.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_NETUTILS_NETLIB_H
+#define __HOST_NETUTILS_NETLIB_H
+
+#include <netinet/in.h>
+
+/*
+ * The host interfaces are left alone, the addresses are only kept so
+ * the application reads back what it set
+ */
+
+int netlib_setmacaddr(const char* ifname, const unsigned char* macaddr);
+int netlib_getmacaddr(const char* ifname, unsigned char* macaddr);
+int netlib_set_ipv4addr(const char* ifname, const struct in_addr* addr);
+int netlib_get_ipv4addr(const char* ifname, struct in_addr* addr);
+int netlib_set_dripv4addr(const char* ifname, const struct in_addr* addr);
+int netlib_set_ipv4netmask(const char* ifname, const struct in_addr* addr);
+int netlib_ifup(const char* ifname);
+int netlib_ifdown(const char* ifname);
+
+#endif
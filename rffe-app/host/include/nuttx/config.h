@@ -0,0 +1,39 @@
+/****************************************************************************
+ * rffe-app/host/include/nuttx/config.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_NUTTX_CONFIG_H
+#define __HOST_NUTTX_CONFIG_H
+
+/*
+ * Host build configuration, stands in for the config.h generated by
+ * the NuttX build from rffe-board/rffe/defconfig
+ */
+
+#define CONFIG_EXAMPLES_RFFE           1
+#define CONFIG_EXAMPLES_RFFE_LOG_LEVEL 3
+#define CONFIG_MAX_TASKS               16
+#define CONFIG_TASK_NAME_SIZE          16
+
+#define FAR
+
+#endif
@@ -0,0 +1,38 @@
+/****************************************************************************
+ * rffe-app/host/include/nuttx/progmem.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_NUTTX_PROGMEM_H
+#define __HOST_NUTTX_PROGMEM_H
+
+#include <sys/types.h>
+
+/*
+ * Flash programming, emulated in RAM by sim_nuttx.c. Blocks are
+ * numbered from the start of the progmem area (the last
+ * CONFIG_LPC17_40_PROGMEM_NSECTORS sectors of the flash).
+ */
+
+ssize_t up_progmem_eraseblock(size_t block);
+ssize_t up_progmem_write(size_t addr, const void* buf, size_t count);
+
+#endif
@@ -0,0 +1,43 @@
+/****************************************************************************
+ * rffe-app/host/include/nuttx/sched.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_NUTTX_SCHED_H
+#define __HOST_NUTTX_SCHED_H
+
+#include <nuttx/config.h>
+#include <sys/types.h>
+#include <stddef.h>
+
+struct tcb_s
+{
+    pid_t pid;
+    void* stack_alloc_ptr;
+    size_t adj_stack_size;
+    char name[CONFIG_TASK_NAME_SIZE + 1];
+};
+
+typedef void (*sched_foreach_t)(FAR struct tcb_s* tcb, FAR void* arg);
+
+void sched_foreach(sched_foreach_t handler, FAR void* arg);
+
+#endif
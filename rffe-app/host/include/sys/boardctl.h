@@ -0,0 +1,36 @@
+/****************************************************************************
+ * rffe-app/host/include/sys/boardctl.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef __HOST_SYS_BOARDCTL_H
+#define __HOST_SYS_BOARDCTL_H
+
+#define BOARDIOC_RESET 0x2e01
+#define BOARDIOC_USER  0x2e80
+
+/*
+ * BOARDIOC_RESET restarts the host executable, BOARDIOC_ATT_SETCODES
+ * arms the per channel attenuator codes of the simulated board
+ */
+int boardctl(unsigned int cmd, unsigned long arg);
+
+#endif
@@ -0,0 +1,377 @@
+/****************************************************************************
+ * rffe-app/host/sim_dev.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <fixedmath.h>
+#include <nuttx/rf/ioctl.h>
+#include <nuttx/rf/attenuator.h>
+#include <nuttx/leds/userled.h>
+
+#include "sim_dev.h"
+
+#define SIM_MAX_FDS 1024
+
+int __real_open(const char* path, int flags, ...);
+int __real_close(int fd);
+ssize_t __real_read(int fd, void* buf, size_t count);
+ssize_t __real_write(int fd, const void* buf, size_t count);
+int __real_ioctl(int fd, unsigned long request, ...);
+int __real_bind(int fd, const struct sockaddr* addr, socklen_t len);
+
+enum sim_dev_type
+{
+    SIM_DEV_NONE,
+    SIM_DEV_TEMP_AC,
+    SIM_DEV_TEMP_BD,
+    SIM_DEV_DAC,
+    SIM_DEV_ATT,
+    SIM_DEV_LEDS,
+};
+
+static const struct
+{
+    const char* path;
+    enum sim_dev_type type;
+} sim_dev_paths[] =
+{
+    {"/dev/temp_ac", SIM_DEV_TEMP_AC},
+    {"/dev/temp_bd", SIM_DEV_TEMP_BD},
+    {"/dev/dac0", SIM_DEV_DAC},
+    {"/dev/att0", SIM_DEV_ATT},
+    {"/dev/statusleds", SIM_DEV_LEDS},
+};
+
+static const char* sim_feram_path;
+static FILE* sim_trace;
+
+/*
+ * Simulated devices get a real descriptor (on /dev/null), the type of
+ * each one is kept here
+ */
+static uint8_t sim_fd_type[SIM_MAX_FDS];
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_dev_state sim_state;
+
+static uint8_t sim_att_codes[SIM_ATT_CHANNELS];
+static int sim_att_armed;
+
+static float sim_ambient = 25.0;
+
+static float sim_ambient_read(void* priv, enum sim_sensor sensor)
+{
+    return sim_ambient;
+}
+
+static struct sim_thermal sim_thermal =
+{
+    .read_temp = sim_ambient_read,
+};
+
+static void sim_trace_printf(const char* fmt, ...)
+{
+    struct timespec now;
+    va_list ap;
+
+    if (sim_trace == NULL)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    fprintf(sim_trace, "%.6f ", now.tv_sec + now.tv_nsec / 1e9);
+    va_start(ap, fmt);
+    vfprintf(sim_trace, fmt, ap);
+    va_end(ap);
+    fputc('\n', sim_trace);
+    fflush(sim_trace);
+}
+
+int sim_dev_init(const char* feram_path, const char* trace_path)
+{
+    struct stat st;
+    int fd;
+
+    fd = __real_open(feram_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        perror(feram_path);
+        return -1;
+    }
+    if (st.st_size < SIM_FERAM_SIZE && ftruncate(fd, SIM_FERAM_SIZE) < 0)
+    {
+        perror(feram_path);
+        __real_close(fd);
+        return -1;
+    }
+    __real_close(fd);
+    sim_feram_path = feram_path;
+
+    if (trace_path != NULL)
+    {
+        sim_trace = fopen(trace_path, "w");
+        if (sim_trace == NULL)
+        {
+            perror(trace_path);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void sim_dev_set_thermal(const struct sim_thermal* thermal)
+{
+    pthread_mutex_lock(&sim_lock);
+    sim_thermal = *thermal;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void sim_dev_set_ambient(float temp)
+{
+    sim_ambient = temp;
+}
+
+int sim_dev_att_setcodes(const uint8_t codes[SIM_ATT_CHANNELS])
+{
+    if (codes == NULL)
+    {
+        pthread_mutex_lock(&sim_lock);
+        sim_att_armed = 0;
+        pthread_mutex_unlock(&sim_lock);
+        return 0;
+    }
+
+    for (int ch = 0; ch < SIM_ATT_CHANNELS; ch++)
+    {
+        if (codes[ch] >= (1 << SIM_ATT_BITS))
+        {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&sim_lock);
+    memcpy(sim_att_codes, codes, SIM_ATT_CHANNELS);
+    sim_att_armed = 1;
+    pthread_mutex_unlock(&sim_lock);
+    return 0;
+}
+
+void sim_dev_get_state(struct sim_dev_state* state)
+{
+    pthread_mutex_lock(&sim_lock);
+    *state = sim_state;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+static enum sim_dev_type sim_fd(int fd)
+{
+    return (fd >= 0 && fd < SIM_MAX_FDS) ? sim_fd_type[fd] : SIM_DEV_NONE;
+}
+
+int __wrap_open(const char* path, int flags, ...)
+{
+    mode_t mode = 0;
+    va_list ap;
+    int fd;
+
+    if (flags & O_CREAT)
+    {
+        va_start(ap, flags);
+        mode = va_arg(ap, int);
+        va_end(ap);
+    }
+
+    if (sim_feram_path != NULL && strcmp(path, "/dev/feram0") == 0)
+    {
+        return __real_open(sim_feram_path, flags & O_ACCMODE);
+    }
+
+    for (size_t i = 0; i < sizeof(sim_dev_paths) / sizeof(sim_dev_paths[0]); i++)
+    {
+        if (strcmp(path, sim_dev_paths[i].path) == 0)
+        {
+            fd = __real_open("/dev/null", O_RDWR);
+            if (fd >= 0 && fd < SIM_MAX_FDS)
+            {
+                sim_fd_type[fd] = sim_dev_paths[i].type;
+            }
+            return fd;
+        }
+    }
+
+    if (strncmp(path, "/dev/", 5) == 0)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    return __real_open(path, flags, mode);
+}
+
+int __wrap_close(int fd)
+{
+    if (sim_fd(fd) != SIM_DEV_NONE)
+    {
+        sim_fd_type[fd] = SIM_DEV_NONE;
+    }
+    return __real_close(fd);
+}
+
+/*
+ * The ADT7320 driver returns the temperature as a b16_t, quantized to
+ * the sensor resolution by the thermal model
+ */
+ssize_t __wrap_read(int fd, void* buf, size_t count)
+{
+    enum sim_dev_type type = sim_fd(fd);
+    b16_t temp;
+
+    if (type != SIM_DEV_TEMP_AC && type != SIM_DEV_TEMP_BD)
+    {
+        return __real_read(fd, buf, count);
+    }
+    if (count < sizeof(temp))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&sim_lock);
+    temp = ftob16(sim_thermal.read_temp(sim_thermal.priv, type == SIM_DEV_TEMP_AC ?
+                                        SIM_SENSOR_AC : SIM_SENSOR_BD));
+    pthread_mutex_unlock(&sim_lock);
+
+    memcpy(buf, &temp, sizeof(temp));
+    return sizeof(temp);
+}
+
+/*
+ * DAC writes: channel, 12 bits code (little endian)
+ */
+ssize_t __wrap_write(int fd, const void* buf, size_t count)
+{
+    const uint8_t* data = buf;
+    float voltage;
+
+    if (sim_fd(fd) != SIM_DEV_DAC)
+    {
+        return __real_write(fd, buf, count);
+    }
+    if (count != 3 || data[0] >= SIM_DAC_CHANNELS)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    voltage = (data[1] | (data[2] & 0x0F) << 8) * SIM_DAC_VREF / 4095.0;
+
+    pthread_mutex_lock(&sim_lock);
+    sim_state.dac_writes++;
+    sim_state.dac[data[0]] = voltage;
+    if (sim_thermal.write_dac != NULL)
+    {
+        sim_thermal.write_dac(sim_thermal.priv, data[0], voltage);
+    }
+    sim_trace_printf("dac %d %.4f", data[0], voltage);
+    pthread_mutex_unlock(&sim_lock);
+
+    return count;
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+    enum sim_dev_type type = sim_fd(fd);
+    unsigned long arg;
+    va_list ap;
+
+    va_start(ap, request);
+    arg = va_arg(ap, unsigned long);
+    va_end(ap);
+
+    if (type == SIM_DEV_ATT && request == RFIOC_SETATT)
+    {
+        const struct attenuator_control* ctrl = (const struct attenuator_control*)arg;
+
+        pthread_mutex_lock(&sim_lock);
+        sim_state.att_writes++;
+
+        /*
+         * Like the board, the armed codes replace the driver's word
+         * for this write only
+         */
+        for (int ch = 0; ch < SIM_ATT_CHANNELS; ch++)
+        {
+            sim_state.attenuation[ch] = sim_att_armed ? sim_att_codes[ch] * 0.5 :
+                                        b16tof(ctrl->attenuation);
+        }
+        sim_att_armed = 0;
+
+        sim_trace_printf("att %.1f %.1f %.1f %.1f", sim_state.attenuation[0],
+                         sim_state.attenuation[1], sim_state.attenuation[2],
+                         sim_state.attenuation[3]);
+        pthread_mutex_unlock(&sim_lock);
+        return 0;
+    }
+    else if (type == SIM_DEV_LEDS && request == ULEDIOC_SETALL)
+    {
+        pthread_mutex_lock(&sim_lock);
+        sim_state.leds = arg;
+        sim_trace_printf("leds 0x%02lx", arg);
+        pthread_mutex_unlock(&sim_lock);
+        return 0;
+    }
+    else if (type != SIM_DEV_NONE)
+    {
+        errno = ENOTTY;
+        return -1;
+    }
+
+    return __real_ioctl(fd, request, arg);
+}
+
+/*
+ * The servers don't set SO_REUSEADDR, on the host a restart (reset)
+ * would fail while old connections are in TIME_WAIT
+ */
+int __wrap_bind(int fd, const struct sockaddr* addr, socklen_t len)
+{
+    int one = 1;
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    return __real_bind(fd, addr, len);
+}
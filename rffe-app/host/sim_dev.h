@@ -0,0 +1,105 @@
+/****************************************************************************
+ * rffe-app/host/sim_dev.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SIM_DEV_H_
+#define SIM_DEV_H_
+
+#include <stdint.h>
+
+/*
+ * Simulated NuttX devices for the host build. The application calls to
+ * open(), read(), write(), ioctl() and close() are redirected here
+ * (linker --wrap): /dev/feram0 is backed by a regular file, the
+ * temperature sensors are read from the thermal model, the DAC, the
+ * attenuator and the status LEDs record what is written to them.
+ * Other paths and descriptors go to the host C library.
+ */
+
+#define SIM_FERAM_SIZE   2048
+#define SIM_DAC_CHANNELS 4
+#define SIM_DAC_VREF     3.3
+#define SIM_ATT_CHANNELS 4
+#define SIM_ATT_BITS     6
+
+enum sim_sensor
+{
+    SIM_SENSOR_AC,
+    SIM_SENSOR_BD,
+};
+
+/*
+ * Thermal model behind the temperature sensors and the DAC
+ */
+struct sim_thermal
+{
+    /* Reading of a sensor in degrees Celsius */
+    float (*read_temp)(void* priv, enum sim_sensor sensor);
+
+    /* Called after each DAC write with the new output voltage */
+    void (*write_dac)(void* priv, int channel, float voltage);
+
+    void* priv;
+};
+
+struct sim_dev_state
+{
+    uint32_t dac_writes;
+    float dac[SIM_DAC_CHANNELS];
+    uint32_t att_writes;
+    float attenuation[SIM_ATT_CHANNELS];
+    uint32_t leds;
+};
+
+/**
+ * @brief Open the FeRAM image (created zeroed, like a blank part, if
+ * it doesn't exist) and the optional trace file
+ * @param trace_path Every DAC, attenuator and LED write is appended to
+ * this file, NULL to disable
+ * @return 0 if success, a negative number on error
+ */
+int sim_dev_init(const char* feram_path, const char* trace_path);
+
+/**
+ * @brief Replace the thermal model, the default one reads a constant
+ * temperature (sim_dev_set_ambient())
+ */
+void sim_dev_set_thermal(const struct sim_thermal* thermal);
+
+/**
+ * @brief Temperature read by the default thermal model
+ */
+void sim_dev_set_ambient(float temp);
+
+/**
+ * @brief Per channel codes for the next attenuator write, like
+ * boardctl(BOARDIOC_ATT_SETCODES) on the board, NULL disarms them
+ * @return 0 if success, -1 (errno set) if a code is out of range
+ */
+int sim_dev_att_setcodes(const uint8_t codes[SIM_ATT_CHANNELS]);
+
+/**
+ * @brief Last values written to the DAC, the attenuator and the LEDs
+ */
+void sim_dev_get_state(struct sim_dev_state* state);
+
+#endif
@@ -0,0 +1,235 @@
+/****************************************************************************
+ * rffe-app/host/sim_main.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <fixedmath.h>
+#include <nuttx/rf/attenuator.h>
+#include <netutils/netlib.h>
+
+#include "sim_dev.h"
+#include "sim_nuttx.h"
+#include "sim_plant.h"
+
+#include "config_file_migrate.h"
+#include "config_file.h"
+#include "att_cal.h"
+#include "rffe_console_cfg.h"
+#include "scpi_server.h"
+#include "fw_update.h"
+#include "temp_control.h"
+#include "boot_time.h"
+#include "discovery.h"
+#include "syslog_sink.h"
+#include "profile.h"
+#include "rffe_log.h"
+#include "svc_loop.h"
+
+static const char* cfg_file = "/dev/feram0";
+
+static void usage(const char* name)
+{
+    printf("Usage: %s [-f feram_image] [-i app_image] [-t trace_file] [-a ambient]\n"
+           "          [-P] [-p name=value]... [get|set <item> [value]]\n"
+           "  -f  FeRAM contents, created blank if missing (default rffe-feram.bin)\n"
+           "  -i  running application image, the base of delta updates\n"
+           "  -t  log every DAC, attenuator and LED write to this file\n"
+           "  -a  temperature read by the sensors (default 25.0)\n"
+           "  -P  close the temperature loop through the thermal plant model\n"
+           "  -p  plant parameter, see sim_plant.h (implies -P)\n"
+           "With get/set, runs the 'rffe' console command and exits.\n", name);
+}
+
+/*
+ * Thermal plant behind the simulated temperature sensors and DAC,
+ * advanced in real time. Called with the device layer lock held.
+ */
+
+static struct timespec sim_plant_last;
+
+static void sim_plant_sync(struct sim_plant* plant)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    sim_plant_advance(plant, (now.tv_sec - sim_plant_last.tv_sec) +
+                      (now.tv_nsec - sim_plant_last.tv_nsec) / 1e9);
+    sim_plant_last = now;
+}
+
+static float sim_plant_read_temp(void* priv, enum sim_sensor sensor)
+{
+    sim_plant_sync(priv);
+    return sim_plant_read(priv, sensor);
+}
+
+static void sim_plant_write_dac(void* priv, int channel, float voltage)
+{
+    sim_plant_sync(priv);
+    if (channel == SIM_PLANT_DAC_AC)
+    {
+        sim_plant_set_drive(priv, SIM_SENSOR_AC, voltage);
+    }
+    else if (channel == SIM_PLANT_DAC_BD)
+    {
+        sim_plant_set_drive(priv, SIM_SENSOR_BD, voltage);
+    }
+}
+
+static void sim_plant_attach(struct sim_plant* plant)
+{
+    struct sim_thermal thermal =
+    {
+        .read_temp = sim_plant_read_temp,
+        .write_dac = sim_plant_write_dac,
+        .priv = plant,
+    };
+
+    clock_gettime(CLOCK_MONOTONIC, &sim_plant_last);
+    sim_dev_set_thermal(&thermal);
+}
+
+/*
+ * Host counterpart of rffe_startup() and rffe_main(): the same startup
+ * sequence without the PLL, the network interface setup and NSH
+ */
+int main(int argc, char* argv[])
+{
+    const char* feram = "rffe-feram.bin";
+    const char* image = NULL;
+    const char* trace = NULL;
+    struct attenuator_control att;
+    struct sim_plant_params plant_params;
+    static struct sim_plant plant;
+    int use_plant = 0;
+    unsigned char mac[6];
+    int opt;
+
+    static float dac_ac = 0.0;
+    static float dac_bd = 0.0;
+
+    sim_plant_defaults(&plant_params);
+
+    while ((opt = getopt(argc, argv, "f:i:t:a:Pp:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            feram = optarg;
+            break;
+        case 'i':
+            image = optarg;
+            break;
+        case 't':
+            trace = optarg;
+            break;
+        case 'a':
+            sim_dev_set_ambient(atof(optarg));
+            plant_params.ambient = atof(optarg);
+            break;
+        case 'P':
+            use_plant = 1;
+            break;
+        case 'p':
+            if (sim_plant_set_param(&plant_params, optarg) < 0)
+            {
+                fprintf(stderr, "Invalid plant parameter: %s\n", optarg);
+                return 1;
+            }
+            use_plant = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    sim_set_argv(argv);
+
+    if (sim_dev_init(feram, trace) < 0 || sim_flash_init(image) < 0)
+    {
+        return 1;
+    }
+
+    if (use_plant)
+    {
+        if (sim_plant_init(&plant, &plant_params) < 0)
+        {
+            fprintf(stderr, "Invalid plant parameters\n");
+            return 1;
+        }
+        sim_plant_attach(&plant);
+    }
+
+    config_migrate_latest(cfg_file);
+
+    if (optind < argc)
+    {
+        argv[optind - 1] = "rffe";
+        return rffe_console_cfg(argc - optind + 1, &argv[optind - 1]);
+    }
+
+    rffe_console_print_version();
+    profile_init();
+    rffe_log_start();
+
+    if (att_cal_load(cfg_file) < 0)
+    {
+        printf("WARNING: invalid attenuator calibration, using identity tables\n");
+    }
+    config_get_attenuation(cfg_file, &att.attenuation);
+    printf("RF attenuation level: %.1f dB\n", b16tof(att.attenuation));
+    att_cal_apply(att.attenuation);
+    boot_time_mark(BOOT_STAGE_ATTENUATION);
+
+    start_temp_control_server(&dac_ac, &dac_bd);
+    boot_time_mark(BOOT_STAGE_TEMP_CONTROL);
+
+    /*
+     * The host interfaces are used as they are, the FeRAM MAC address
+     * is only reported (discovery, syslog hostname)
+     */
+    config_get_mac_addr(cfg_file, mac);
+    netlib_setmacaddr("eth0", mac);
+    boot_time_mark(BOOT_STAGE_LINK_UP);
+    boot_time_mark(BOOT_STAGE_NETWORK);
+
+    start_fw_update_server();
+    start_discovery_server();
+#ifdef CONFIG_EXAMPLES_RFFE_SHARED_SERVICES
+    svc_loop_start();
+#endif
+    syslog_sink_start();
+    boot_time_mark(BOOT_STAGE_LISTENERS);
+    boot_time_print();
+
+    return scpi_server_start(&dac_ac, &dac_bd) < 0 ? 1 : 0;
+}
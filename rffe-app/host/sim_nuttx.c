@@ -0,0 +1,299 @@
+/****************************************************************************
+ * rffe-app/host/sim_nuttx.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <nuttx/config.h>
+#include <nuttx/arch.h>
+#include <nuttx/progmem.h>
+#include <sys/boardctl.h>
+#include <arch/board/board.h>
+#include <netutils/netlib.h>
+#include <netutils/dhcpc.h>
+
+#include "sim_nuttx.h"
+#include "sim_dev.h"
+
+static char** sim_argv;
+
+static pthread_mutex_t sim_net_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned char sim_mac[6];
+static struct in_addr sim_ipaddr;
+
+/*
+ * Flash
+ */
+
+int sim_flash_init(const char* image)
+{
+    void* flash = mmap((void*)SIM_FLASH_APP_START, SIM_FLASH_END - SIM_FLASH_APP_START,
+                       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                       -1, 0);
+
+    if (flash != (void*)SIM_FLASH_APP_START)
+    {
+        fprintf(stderr, "Can't map the flash at 0x%x (vm.mmap_min_addr?)\n", SIM_FLASH_APP_START);
+        return -1;
+    }
+    memset(flash, 0xFF, SIM_FLASH_END - SIM_FLASH_APP_START);
+
+    if (image != NULL)
+    {
+        FILE* f = fopen(image, "rb");
+
+        if (f == NULL)
+        {
+            perror(image);
+            return -1;
+        }
+        fread(flash, 1, SIM_FLASH_PROGMEM_START - SIM_FLASH_APP_START, f);
+        fclose(f);
+    }
+
+    return 0;
+}
+
+ssize_t up_progmem_eraseblock(size_t block)
+{
+    uintptr_t addr = SIM_FLASH_PROGMEM_START + block * SIM_FLASH_SECTOR_SIZE;
+
+    if (addr >= SIM_FLASH_END)
+    {
+        return -EFAULT;
+    }
+
+    memset((void*)addr, 0xFF, SIM_FLASH_SECTOR_SIZE);
+    return SIM_FLASH_SECTOR_SIZE;
+}
+
+/*
+ * Like the real flash, programming can only clear bits
+ */
+ssize_t up_progmem_write(size_t addr, const void* buf, size_t count)
+{
+    const uint8_t* src = buf;
+    uint8_t* dst = (uint8_t*)(uintptr_t)addr;
+
+    if (addr < SIM_FLASH_PROGMEM_START || addr + count > SIM_FLASH_END)
+    {
+        return -EFAULT;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] &= src[i];
+    }
+    return count;
+}
+
+/*
+ * boardctl
+ */
+
+void sim_set_argv(char* argv[])
+{
+    sim_argv = argv;
+}
+
+int boardctl(unsigned int cmd, unsigned long arg)
+{
+    if (cmd == BOARDIOC_ATT_SETCODES)
+    {
+        return sim_dev_att_setcodes((const uint8_t*)arg);
+    }
+
+    if (cmd != BOARDIOC_RESET || sim_argv == NULL)
+    {
+        errno = ENOTTY;
+        return -1;
+    }
+
+    printf("Reset requested, restarting\n");
+    fflush(stdout);
+
+    /*
+     * Don't leak the sockets and devices into the new image
+     */
+    for (int fd = 3; fd < 1024; fd++)
+    {
+        close(fd);
+    }
+
+    char path[256];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+
+    if (len > 0)
+    {
+        path[len] = '\0';
+        execv(path, sim_argv);
+    }
+    perror("execv");
+    _exit(1);
+}
+
+/*
+ * Clock: CLOCK_MONOTONIC counts from the start of the executable, like
+ * the board uptime (boot times, DHCP lease timers, log timestamps)
+ */
+
+int __real_clock_gettime(clockid_t clock, struct timespec* ts);
+
+static pthread_once_t sim_boot_once = PTHREAD_ONCE_INIT;
+static struct timespec sim_boot;
+
+static void sim_boot_init(void)
+{
+    __real_clock_gettime(CLOCK_MONOTONIC, &sim_boot);
+}
+
+int __wrap_clock_gettime(clockid_t clock, struct timespec* ts)
+{
+    int ret;
+
+    pthread_once(&sim_boot_once, sim_boot_init);
+
+    ret = __real_clock_gettime(clock, ts);
+    if (ret == 0 && clock == CLOCK_MONOTONIC)
+    {
+        ts->tv_sec -= sim_boot.tv_sec;
+        ts->tv_nsec -= sim_boot.tv_nsec;
+        if (ts->tv_nsec < 0)
+        {
+            ts->tv_nsec += 1000000000;
+            ts->tv_sec--;
+        }
+    }
+    return ret;
+}
+
+/*
+ * Scheduler
+ */
+
+/*
+ * The host threads have no TCB, the process is reported as a single
+ * task with an unknown stack usage
+ */
+void sched_foreach(sched_foreach_t handler, FAR void* arg)
+{
+    struct tcb_s tcb;
+    struct rlimit limit;
+
+    memset(&tcb, 0, sizeof(tcb));
+    tcb.pid = getpid();
+    tcb.stack_alloc_ptr = &tcb;
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+    {
+        tcb.adj_stack_size = limit.rlim_cur;
+    }
+    strncpy(tcb.name, "rffe-host", CONFIG_TASK_NAME_SIZE);
+
+    handler(&tcb, arg);
+}
+
+size_t up_check_tcbstack(FAR struct tcb_s* tcb)
+{
+    return 0;
+}
+
+/*
+ * Network
+ */
+
+int netlib_setmacaddr(const char* ifname, const unsigned char* macaddr)
+{
+    pthread_mutex_lock(&sim_net_lock);
+    memcpy(sim_mac, macaddr, sizeof(sim_mac));
+    pthread_mutex_unlock(&sim_net_lock);
+    return 0;
+}
+
+int netlib_getmacaddr(const char* ifname, unsigned char* macaddr)
+{
+    pthread_mutex_lock(&sim_net_lock);
+    memcpy(macaddr, sim_mac, sizeof(sim_mac));
+    pthread_mutex_unlock(&sim_net_lock);
+    return 0;
+}
+
+int netlib_set_ipv4addr(const char* ifname, const struct in_addr* addr)
+{
+    pthread_mutex_lock(&sim_net_lock);
+    sim_ipaddr = *addr;
+    pthread_mutex_unlock(&sim_net_lock);
+    return 0;
+}
+
+int netlib_get_ipv4addr(const char* ifname, struct in_addr* addr)
+{
+    pthread_mutex_lock(&sim_net_lock);
+    *addr = sim_ipaddr;
+    pthread_mutex_unlock(&sim_net_lock);
+    return 0;
+}
+
+int netlib_set_dripv4addr(const char* ifname, const struct in_addr* addr)
+{
+    return 0;
+}
+
+int netlib_set_ipv4netmask(const char* ifname, const struct in_addr* addr)
+{
+    return 0;
+}
+
+int netlib_ifup(const char* ifname)
+{
+    return 0;
+}
+
+int netlib_ifdown(const char* ifname)
+{
+    return 0;
+}
+
+void* dhcpc_open(const char* interface, const void* mac_addr, int mac_len)
+{
+    return NULL;
+}
+
+int dhcpc_request(void* handle, struct dhcpc_state* presult)
+{
+    return -1;
+}
+
+void dhcpc_close(void* handle)
+{
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+ * rffe-app/host/sim_nuttx.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SIM_NUTTX_H_
+#define SIM_NUTTX_H_
+
+/*
+ * Host stand-ins for the NuttX services that aren't devices: the
+ * flash (progmem), boardctl(), netlib and the DHCP client
+ */
+
+/*
+ * LPC1769 flash layout: the application starts after the bootloader,
+ * the progmem area is the last CONFIG_LPC17_40_PROGMEM_NSECTORS (7)
+ * 32 KiB sectors
+ */
+#define SIM_FLASH_APP_START     0x10000
+#define SIM_FLASH_PROGMEM_START 0x48000
+#define SIM_FLASH_END           0x80000
+#define SIM_FLASH_SECTOR_SIZE   0x8000
+
+/**
+ * @brief Map the emulated flash at its LPC1769 addresses (the firmware
+ * update server reads it through pointers) and load the running
+ * application image
+ * @param image Binary loaded at SIM_FLASH_APP_START (the base of delta
+ * updates), NULL to leave the application area erased
+ * @return 0 if success, a negative number on error
+ */
+int sim_flash_init(const char* image);
+
+/**
+ * @brief Arguments used to restart the executable on BOARDIOC_RESET
+ */
+void sim_set_argv(char* argv[]);
+
+#endif
@@ -0,0 +1,217 @@
+/****************************************************************************
+ * rffe-app/host/sim_plant.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim_plant.h"
+
+void sim_plant_defaults(struct sim_plant_params* params)
+{
+    params->ambient = 25.0;
+    params->gain = 12.0;
+    params->tau = 240.0;
+    params->dead = 6.0;
+    params->coupling = 900.0;
+    params->vsat = 3.0;
+    params->noise = 0.03;
+    params->resolution = 0.0625;
+    params->step = 0.01;
+    params->seed = 1;
+}
+
+int sim_plant_set_param(struct sim_plant_params* params, const char* assignment)
+{
+    static const struct
+    {
+        const char* name;
+        size_t offset;
+    } names[] =
+    {
+        {"ambient", offsetof(struct sim_plant_params, ambient)},
+        {"gain", offsetof(struct sim_plant_params, gain)},
+        {"tau", offsetof(struct sim_plant_params, tau)},
+        {"dead", offsetof(struct sim_plant_params, dead)},
+        {"coupling", offsetof(struct sim_plant_params, coupling)},
+        {"vsat", offsetof(struct sim_plant_params, vsat)},
+        {"noise", offsetof(struct sim_plant_params, noise)},
+        {"resolution", offsetof(struct sim_plant_params, resolution)},
+        {"step", offsetof(struct sim_plant_params, step)},
+    };
+    const char* value = strchr(assignment, '=');
+    size_t len;
+    char* end;
+
+    if (value == NULL)
+    {
+        return -1;
+    }
+    len = value - assignment;
+
+    if (len == 4 && strncmp(assignment, "seed", len) == 0)
+    {
+        params->seed = strtoul(value + 1, &end, 0);
+        return (*end == '\0' && end != value + 1) ? 0 : -1;
+    }
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strlen(names[i].name) == len && strncmp(assignment, names[i].name, len) == 0)
+        {
+            float* param = (float*)((char*)params + names[i].offset);
+
+            *param = strtof(value + 1, &end);
+            return (*end == '\0' && end != value + 1) ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+int sim_plant_init(struct sim_plant* plant, const struct sim_plant_params* params)
+{
+    memset(plant, 0, sizeof(*plant));
+    plant->params = *params;
+
+    if (params->step <= 0 || params->tau <= 0 || params->dead < 0)
+    {
+        return -1;
+    }
+
+    plant->history_len = (int)(params->dead / params->step + 0.5) + 1;
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        plant->temp[ch] = params->ambient;
+        plant->history[ch] = calloc(plant->history_len, sizeof(float));
+        if (plant->history[ch] == NULL)
+        {
+            sim_plant_free(plant);
+            return -1;
+        }
+    }
+
+    plant->rng = params->seed ? params->seed : 1;
+    return 0;
+}
+
+void sim_plant_free(struct sim_plant* plant)
+{
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        free(plant->history[ch]);
+        plant->history[ch] = NULL;
+    }
+}
+
+static void sim_plant_step(struct sim_plant* plant)
+{
+    const struct sim_plant_params* p = &plant->params;
+    float delayed[SIM_PLANT_CHANNELS];
+    float dtemp[SIM_PLANT_CHANNELS];
+    int oldest = (plant->history_pos + 1) % plant->history_len;
+
+    /*
+     * The history holds the last dead / step drive values, the oldest
+     * one reaches the sensor now
+     */
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        plant->history[ch][plant->history_pos] = plant->drive[ch];
+        delayed[ch] = plant->history[ch][oldest];
+    }
+    plant->history_pos = oldest;
+
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        float u = delayed[ch] < p->vsat ? delayed[ch] : p->vsat;
+        float other = plant->temp[SIM_PLANT_CHANNELS - 1 - ch];
+
+        dtemp[ch] = (p->gain * u - (plant->temp[ch] - p->ambient)) / p->tau;
+        if (p->coupling > 0)
+        {
+            dtemp[ch] += (other - plant->temp[ch]) / p->coupling;
+        }
+    }
+
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        plant->temp[ch] += dtemp[ch] * p->step;
+    }
+    plant->time += p->step;
+}
+
+void sim_plant_advance(struct sim_plant* plant, double dt)
+{
+    plant->residue += dt;
+    while (plant->residue >= plant->params.step)
+    {
+        sim_plant_step(plant);
+        plant->residue -= plant->params.step;
+    }
+}
+
+void sim_plant_set_drive(struct sim_plant* plant, int channel, float voltage)
+{
+    plant->drive[channel] = voltage > 0 ? voltage : 0;
+}
+
+/*
+ * xorshift32 and Box-Muller, reproducible from the seed
+ */
+static float sim_plant_uniform(struct sim_plant* plant)
+{
+    plant->rng ^= plant->rng << 13;
+    plant->rng ^= plant->rng >> 17;
+    plant->rng ^= plant->rng << 5;
+    return (plant->rng >> 8) * (1.0f / 16777216.0f);
+}
+
+static float sim_plant_gaussian(struct sim_plant* plant)
+{
+    float u1 = sim_plant_uniform(plant);
+    float u2 = sim_plant_uniform(plant);
+
+    return sqrtf(-2.0f * logf(u1 + 1e-12f)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+float sim_plant_read(struct sim_plant* plant, int channel)
+{
+    const struct sim_plant_params* p = &plant->params;
+    float temp = plant->temp[channel];
+
+    if (p->noise > 0)
+    {
+        temp += p->noise * sim_plant_gaussian(plant);
+    }
+    if (p->resolution > 0)
+    {
+        temp = roundf(temp / p->resolution) * p->resolution;
+    }
+    return temp;
+}
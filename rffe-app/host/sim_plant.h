@@ -0,0 +1,116 @@
+/****************************************************************************
+ * rffe-app/host/sim_plant.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SIM_PLANT_H_
+#define SIM_PLANT_H_
+
+#include <stdint.h>
+
+#include "sim_dev.h"
+
+/*
+ * Thermal plant of the two front-end channels (A/C and B/D): each one
+ * is a first order plus dead time thermal mass heated through the DAC,
+ * the channels exchange heat with each other, the heater drive
+ * saturates and the ADT7320 readings are noisy and quantized.
+ *
+ *   dT/dt = (gain * min(u(t - dead), vsat) - (T - ambient)) / tau
+ *           + (T_other - T) / coupling
+ *
+ * Channels are indexed by enum sim_sensor.
+ */
+
+#define SIM_PLANT_CHANNELS 2
+
+/*
+ * DAC channels driving the heaters (see temp_control.c)
+ */
+#define SIM_PLANT_DAC_AC 3
+#define SIM_PLANT_DAC_BD 2
+
+struct sim_plant_params
+{
+    float ambient;      /* degrees C */
+    float gain;         /* degrees C per heater volt, steady state */
+    float tau;          /* thermal time constant (s) */
+    float dead;         /* dead time between the heater and the sensor (s) */
+    float coupling;     /* time constant of the heat exchange between channels (s), 0: none */
+    float vsat;         /* heater drive saturation (V) */
+    float noise;        /* sensor noise standard deviation (degrees C) */
+    float resolution;   /* sensor resolution (degrees C), 0.0625 for the ADT7320 in 13 bits mode */
+    float step;         /* integration step (s) */
+    uint32_t seed;      /* sensor noise seed */
+};
+
+struct sim_plant
+{
+    struct sim_plant_params params;
+    float temp[SIM_PLANT_CHANNELS];
+    float drive[SIM_PLANT_CHANNELS];
+
+    /* Heater drive history for the dead time, one entry per step */
+    float* history[SIM_PLANT_CHANNELS];
+    int history_len;
+    int history_pos;
+
+    double time;
+    double residue;
+    uint32_t rng;
+};
+
+/**
+ * @brief Fill the parameters with the defaults
+ */
+void sim_plant_defaults(struct sim_plant_params* params);
+
+/**
+ * @brief Set a parameter from a "name=value" string (command line)
+ * @return 0 if success, a negative number if the name or the value is
+ * invalid
+ */
+int sim_plant_set_param(struct sim_plant_params* params, const char* assignment);
+
+/**
+ * @brief Initialize the plant at the ambient temperature, heaters off
+ * @return 0 if success, a negative number on error
+ */
+int sim_plant_init(struct sim_plant* plant, const struct sim_plant_params* params);
+
+void sim_plant_free(struct sim_plant* plant);
+
+/**
+ * @brief Advance the simulated time
+ */
+void sim_plant_advance(struct sim_plant* plant, double dt);
+
+/**
+ * @brief Set the heater drive voltage of a channel
+ */
+void sim_plant_set_drive(struct sim_plant* plant, int channel, float voltage);
+
+/**
+ * @brief Sensor reading of a channel (noise and quantization applied)
+ */
+float sim_plant_read(struct sim_plant* plant, int channel);
+
+#endif
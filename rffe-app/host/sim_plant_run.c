@@ -0,0 +1,260 @@
+/****************************************************************************
+ * rffe-app/host/sim_plant_run.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Faster than real time closed loop run of the temperature controller
+ * (pid.c, driven like temp_control.c does) against the plant model.
+ * Prints the step response scores of each channel as JSON.
+ */
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "pid.h"
+#include "sim_plant.h"
+
+/*
+ * Same as temp_control.c
+ */
+#define CONTROL_PERIOD 0.1
+#define DAC_VREF       3.3
+#define DAC_MAX_CODE   4095
+
+static const char* channel_names[SIM_PLANT_CHANNELS] = {"ac", "bd"};
+
+struct score
+{
+    float start;
+    float max;
+    double rise_10;
+    double rise_90;
+    double last_outside;
+    double iae;
+    double tail_error;
+    int tail_samples;
+};
+
+static void usage(const char* name)
+{
+    printf("Usage: %s [-k kc,ti,td] [-s setpoint] [-t duration] [-b band] [-o trace.csv]\n"
+           "          [-p name=value]...\n"
+           "  -k  PID gains, as stored in the FeRAM (default 1,1,1, the factory values)\n"
+           "  -s  setpoint of both channels in degrees C (default 50)\n"
+           "  -t  simulated time in seconds (default 1800)\n"
+           "  -b  settling band in degrees C (default 0.5)\n"
+           "  -o  write the time, temperature and heater drive of both channels\n"
+           "  -p  plant parameter: ambient, gain, tau, dead, coupling, vsat, noise,\n"
+           "      resolution, step or seed (see sim_plant.h)\n", name);
+}
+
+/*
+ * write_dac_voltage() truncates to the 12 bits DAC code
+ */
+static float dac_quantize(float voltage)
+{
+    int code = (voltage / DAC_VREF) * DAC_MAX_CODE;
+
+    return code * DAC_VREF / DAC_MAX_CODE;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+    struct sim_plant_params params;
+    struct sim_plant plant;
+    pid_ctrl_t pid[SIM_PLANT_CHANNELS];
+    struct score score[SIM_PLANT_CHANNELS];
+    float kc = 1.0, ti = 1.0, td = 1.0;
+    float setpoint = 50.0;
+    float band = 0.5;
+    double duration = 1800.0;
+    FILE* trace = NULL;
+    double tail_start;
+    double wall;
+    long steps;
+    int opt;
+
+    sim_plant_defaults(&params);
+
+    while ((opt = getopt(argc, argv, "k:s:t:b:o:p:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'k':
+            if (sscanf(optarg, "%f,%f,%f", &kc, &ti, &td) != 3)
+            {
+                fprintf(stderr, "Invalid gains: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            setpoint = atof(optarg);
+            break;
+        case 't':
+            duration = atof(optarg);
+            break;
+        case 'b':
+            band = atof(optarg);
+            break;
+        case 'o':
+            trace = fopen(optarg, "w");
+            if (trace == NULL)
+            {
+                perror(optarg);
+                return 1;
+            }
+            fprintf(trace, "time,temp_ac,temp_bd,drive_ac,drive_bd\n");
+            break;
+        case 'p':
+            if (sim_plant_set_param(&params, optarg) < 0)
+            {
+                fprintf(stderr, "Invalid plant parameter: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (sim_plant_init(&plant, &params) < 0)
+    {
+        fprintf(stderr, "Invalid plant parameters\n");
+        return 1;
+    }
+
+    /*
+     * Controller state as set by temp_control_init(), gains and
+     * setpoint as read from the FeRAM by temp_control_step()
+     */
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        pid_init(&pid[ch], kc, ti, td, setpoint, DAC_VREF, 0.0, CONTROL_PERIOD);
+        pid[ch].setpoint = setpoint;
+
+        memset(&score[ch], 0, sizeof(score[ch]));
+        score[ch].start = plant.temp[ch];
+        score[ch].max = plant.temp[ch];
+        score[ch].rise_10 = -1;
+        score[ch].rise_90 = -1;
+    }
+
+    steps = (long)(duration / CONTROL_PERIOD + 0.5);
+    tail_start = (steps - steps / 10) * CONTROL_PERIOD - CONTROL_PERIOD / 2;
+    wall = now();
+
+    for (long i = 0; i < steps; i++)
+    {
+        double t = i * CONTROL_PERIOD;
+        float drive[SIM_PLANT_CHANNELS];
+
+        for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+        {
+            drive[ch] = dac_quantize(pid_compute(&pid[ch], sim_plant_read(&plant, ch)));
+            sim_plant_set_drive(&plant, ch, drive[ch]);
+        }
+
+        sim_plant_advance(&plant, CONTROL_PERIOD);
+        t += CONTROL_PERIOD;
+
+        /*
+         * Scores use the plant temperature, not the noisy readings
+         */
+        for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+        {
+            struct score* s = &score[ch];
+            float temp = plant.temp[ch];
+            float error = setpoint - temp;
+            float progress = (temp - s->start) / (setpoint - s->start);
+
+            if (temp > s->max) s->max = temp;
+            if (s->rise_10 < 0 && progress >= 0.1) s->rise_10 = t;
+            if (s->rise_90 < 0 && progress >= 0.9) s->rise_90 = t;
+            if (fabsf(error) > band) s->last_outside = t;
+            s->iae += fabsf(error) * CONTROL_PERIOD;
+
+            /*
+             * Steady state: mean error over the last 10 % of the run
+             */
+            if (t > tail_start)
+            {
+                s->tail_error += error;
+                s->tail_samples++;
+            }
+        }
+
+        if (trace != NULL)
+        {
+            fprintf(trace, "%.1f,%.4f,%.4f,%.4f,%.4f\n", t, plant.temp[SIM_SENSOR_AC],
+                    plant.temp[SIM_SENSOR_BD], drive[SIM_SENSOR_AC], drive[SIM_SENSOR_BD]);
+        }
+    }
+
+    wall = now() - wall;
+
+    printf("{\n  \"duration\": %.1f,\n  \"setpoint\": %.3f,\n  \"gains\": [%g, %g, %g],\n"
+           "  \"wall_time\": %.3f,\n  \"speedup\": %.0f,\n",
+           duration, setpoint, kc, ti, td, wall, wall > 0 ? duration / wall : 0.0);
+
+    for (int ch = 0; ch < SIM_PLANT_CHANNELS; ch++)
+    {
+        struct score* s = &score[ch];
+        float overshoot = s->max > setpoint ? s->max - setpoint : 0.0;
+        /*
+         * Settled if it stays in the band for the whole steady state window
+         */
+        double settling = (s->last_outside <= tail_start) ? s->last_outside : -1;
+
+        printf("  \"%s\": {\"rise_time\": %.1f, \"overshoot\": %.3f, \"overshoot_pct\": %.1f, "
+               "\"settling_time\": %.1f, \"steady_state_error\": %.4f, \"iae\": %.1f}%s\n",
+               channel_names[ch],
+               (s->rise_10 >= 0 && s->rise_90 >= 0) ? s->rise_90 - s->rise_10 : -1.0,
+               overshoot, 100.0 * overshoot / fabsf(setpoint - s->start), settling,
+               s->tail_samples ? s->tail_error / s->tail_samples : 0.0, s->iae,
+               ch == SIM_PLANT_CHANNELS - 1 ? "" : ",");
+    }
+    printf("}\n");
+
+    if (trace != NULL)
+    {
+        fclose(trace);
+    }
+    sim_plant_free(&plant);
+    return 0;
+}
@@ -118,6 +118,26 @@ extern "C" {
 #define USE_CUSTOM_DTOSTRE 0
 #endif
 
+/**
+ * Hooks run around the command lookup and the command callbacks, e.g.
+ * for profiling. BEGIN may declare local variables used by END.
+ */
+#ifndef SCPI_HOOK_FIND_BEGIN
+#define SCPI_HOOK_FIND_BEGIN(context)
+#endif
+
+#ifndef SCPI_HOOK_FIND_END
+#define SCPI_HOOK_FIND_END(context)
+#endif
+
+#ifndef SCPI_HOOK_CALLBACK_BEGIN
+#define SCPI_HOOK_CALLBACK_BEGIN(context, cmd)
+#endif
+
+#ifndef SCPI_HOOK_CALLBACK_END
+#define SCPI_HOOK_CALLBACK_END(context, cmd, result)
+#endif
+
 #ifndef USE_UNITS_IMPERIAL
 #define USE_UNITS_IMPERIAL 0
 #endif
@@ -138,7 +138,11 @@ static scpi_bool_t processCommand(scpi_t * context) {
 
     /* if callback exists - call command callback */
     if (cmd->callback != NULL) {
-        if ((cmd->callback(context) != SCPI_RES_OK)) {
+        scpi_result_t res;
+        SCPI_HOOK_CALLBACK_BEGIN(context, cmd);
+        res = cmd->callback(context);
+        SCPI_HOOK_CALLBACK_END(context, cmd, res);
+        if (res != SCPI_RES_OK) {
             if (!context->cmd_error) {
                 SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
             }
@@ -167,15 +171,20 @@ static scpi_bool_t processCommand(scpi_t * context) {
 static scpi_bool_t findCommandHeader(scpi_t * context, const char * header, int len) {
     int32_t i;
     const scpi_command_t * cmd;
+    scpi_bool_t result = FALSE;
+    SCPI_HOOK_FIND_BEGIN(context);
 
     for (i = 0; context->cmdlist[i].pattern != NULL; i++) {
         cmd = &context->cmdlist[i];
         if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
             context->param_list.cmd = cmd;
-            return TRUE;
+            result = TRUE;
+            break;
         }
     }
-    return FALSE;
+
+    SCPI_HOOK_FIND_END(context);
+    return result;
 }
 
 /**
@@ -0,0 +1,698 @@
+/****************************************************************************
+ * rffe-app/libscpi/test/bench_scpi.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Host microbenchmarks of libscpi: command input on RFFE command streams,
+ * pattern matching, numbers with units, number formatting, compound
+ * commands and the error queue. Reports ns/op (best of several runs) and
+ * heap allocations per op, and compares them with a stored baseline:
+ *
+ *   bench_scpi.bench [-b baseline] [-w baseline] [-t tolerance] [filter]
+ *
+ * The allocation counters need the link time wrapping of the allocator
+ * functions done by the Makefile ('make bench').
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "scpi/scpi.h"
+#include "../src/utils_private.h"
+
+/*
+ * Allocation counters
+ */
+
+static long alloc_count;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+char* __real_strndup(const char* s, size_t n);
+char* __real_strdup(const char* s);
+
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t nmemb, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+char* __wrap_strndup(const char* s, size_t n);
+char* __wrap_strdup(const char* s);
+
+void* __wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+    alloc_count++;
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    alloc_count++;
+    return __real_realloc(ptr, size);
+}
+
+char* __wrap_strndup(const char* s, size_t n) {
+    alloc_count++;
+    return __real_strndup(s, n);
+}
+
+char* __wrap_strdup(const char* s) {
+    alloc_count++;
+    return __real_strdup(s);
+}
+
+/*
+ * SCPI context with the RFFE command table (rffe-app/scpi_tables.c),
+ * the callbacks only parse their parameter or return a constant
+ */
+
+static volatile float sink;
+
+static scpi_result_t bench_query(scpi_t* context) {
+    SCPI_ResultFloat(context, 25.0625f);
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t bench_set_float(scpi_t* context) {
+    float value;
+
+    if (!SCPI_ParamFloat(context, &value, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    sink = value;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t bench_set_voltage(scpi_t* context) {
+    scpi_number_t value;
+
+    if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &value, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    if (value.unit != SCPI_UNIT_NONE && value.unit != SCPI_UNIT_VOLT) {
+        SCPI_ErrorPush(context, SCPI_ERROR_INVALID_SUFFIX);
+        return SCPI_RES_ERR;
+    }
+    sink = value.content.value;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t bench_set_text(scpi_t* context) {
+    char text[32];
+    size_t len;
+
+    if (!SCPI_ParamCopyText(context, text, sizeof(text), &len, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    sink = len;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t bench_none(scpi_t* context) {
+    (void) context;
+    return SCPI_RES_OK;
+}
+
+static const scpi_command_t scpi_commands[] = {
+    { .pattern = "*CLS", .callback = SCPI_CoreCls,},
+    { .pattern = "*ESE", .callback = SCPI_CoreEse,},
+    { .pattern = "*ESE?", .callback = SCPI_CoreEseQ,},
+    { .pattern = "*ESR?", .callback = SCPI_CoreEsrQ,},
+    { .pattern = "*IDN?", .callback = SCPI_CoreIdnQ,},
+    { .pattern = "*OPC", .callback = SCPI_CoreOpc,},
+    { .pattern = "*OPC?", .callback = SCPI_CoreOpcQ,},
+    { .pattern = "*RST", .callback = SCPI_CoreRst,},
+    { .pattern = "*SRE", .callback = SCPI_CoreSre,},
+    { .pattern = "*SRE?", .callback = SCPI_CoreSreQ,},
+    { .pattern = "*STB?", .callback = SCPI_CoreStbQ,},
+    { .pattern = "*TST?", .callback = bench_query,},
+    { .pattern = "*WAI", .callback = SCPI_CoreWai,},
+
+    { .pattern = "SYSTem:ERRor[:NEXT]?", .callback = SCPI_SystemErrorNextQ,},
+    { .pattern = "SYSTem:ERRor:COUNt?", .callback = SCPI_SystemErrorCountQ,},
+    { .pattern = "SYSTem:VERSion?", .callback = SCPI_SystemVersionQ,},
+
+    { .pattern = "STATus:QUEStionable[:EVENt]?", .callback = SCPI_StatusQuestionableEventQ,},
+    { .pattern = "STATus:QUEStionable:ENABle", .callback = SCPI_StatusQuestionableEnable,},
+    { .pattern = "STATus:QUEStionable:ENABle?", .callback = SCPI_StatusQuestionableEnableQ,},
+
+    { .pattern = "STATus:PRESet", .callback = SCPI_StatusPreset,},
+
+    { .pattern = "MEASure:TEMPerature:AC?", .callback = bench_query,},
+    { .pattern = "MEASure:TEMPerature:BD?", .callback = bench_query,},
+    { .pattern = "SET:ATTEnuation", .callback = bench_set_float,},
+    { .pattern = "GET:ATTEnuation?", .callback = bench_query,},
+    { .pattern = "SET:ATTEnuation:CALibration:A", .callback = bench_set_text,},
+    { .pattern = "SET:ATTEnuation:CALibration:B", .callback = bench_set_text,},
+    { .pattern = "SET:ATTEnuation:CALibration:C", .callback = bench_set_text,},
+    { .pattern = "SET:ATTEnuation:CALibration:D", .callback = bench_set_text,},
+    { .pattern = "GET:ATTEnuation:CALibration:A?", .callback = bench_query,},
+    { .pattern = "GET:ATTEnuation:CALibration:B?", .callback = bench_query,},
+    { .pattern = "GET:ATTEnuation:CALibration:C?", .callback = bench_query,},
+    { .pattern = "GET:ATTEnuation:CALibration:D?", .callback = bench_query,},
+    { .pattern = "SET:TEMPerature:SETPoint:AC", .callback = bench_set_float,},
+    { .pattern = "SET:TEMPerature:SETPoint:BD", .callback = bench_set_float,},
+    { .pattern = "GET:TEMPerature:SETPoint:AC?", .callback = bench_query,},
+    { .pattern = "GET:TEMPerature:SETPoint:BD?", .callback = bench_query,},
+    { .pattern = "SET:PID:Kc:AC", .callback = bench_set_float,},
+    { .pattern = "SET:PID:Ti:AC", .callback = bench_set_float,},
+    { .pattern = "SET:PID:Td:AC", .callback = bench_set_float,},
+    { .pattern = "SET:PID:Kc:BD", .callback = bench_set_float,},
+    { .pattern = "SET:PID:Ti:BD", .callback = bench_set_float,},
+    { .pattern = "SET:PID:Td:BD", .callback = bench_set_float,},
+    { .pattern = "GET:PID:Kc:AC?", .callback = bench_query,},
+    { .pattern = "GET:PID:Ti:AC?", .callback = bench_query,},
+    { .pattern = "GET:PID:Td:AC?", .callback = bench_query,},
+    { .pattern = "GET:PID:Kc:BD?", .callback = bench_query,},
+    { .pattern = "GET:PID:Ti:BD?", .callback = bench_query,},
+    { .pattern = "GET:PID:Td:BD?", .callback = bench_query,},
+    { .pattern = "SET:TEMPControl:AUTOmatic", .callback = bench_set_float,},
+    { .pattern = "GET:TEMPControl:AUTOmatic?", .callback = bench_query,},
+    { .pattern = "SET:DAC:OUTput:AC", .callback = bench_set_voltage,},
+    { .pattern = "SET:DAC:OUTput:BD", .callback = bench_set_voltage,},
+    { .pattern = "GET:DAC:OUTput:AC?", .callback = bench_query,},
+    { .pattern = "GET:DAC:OUTput:BD?", .callback = bench_query,},
+    { .pattern = "SET:IPAddr", .callback = bench_set_text,},
+    { .pattern = "GET:IPAddr?", .callback = bench_query,},
+    { .pattern = "SET:GATEwayaddr", .callback = bench_set_text,},
+    { .pattern = "GET:GATEwayaddr?", .callback = bench_query,},
+    { .pattern = "SET:NETMask", .callback = bench_set_text,},
+    { .pattern = "GET:NETMask?", .callback = bench_query,},
+    { .pattern = "SET:DHCPMode", .callback = bench_set_float,},
+    { .pattern = "GET:DHCPMode?", .callback = bench_query,},
+    { .pattern = "GET:DHCPLease?", .callback = bench_query,},
+    { .pattern = "SET:SYSLog", .callback = bench_set_text,},
+    { .pattern = "GET:SYSLog?", .callback = bench_query,},
+    { .pattern = "GET:VERsion?", .callback = bench_query,},
+    { .pattern = "SYSTem:RESet", .callback = bench_none,},
+    { .pattern = "SYSTem:BOOT:TIMe?", .callback = bench_query,},
+    { .pattern = "SYSTem:STACk?", .callback = bench_query,},
+    { .pattern = "SYSTem:POOL?", .callback = bench_query,},
+    { .pattern = "SYSTem:PROFile?", .callback = bench_query,},
+    { .pattern = "SYSTem:PROFile:RESet", .callback = bench_none,},
+    { .pattern = "SYSTem:STATistics?", .callback = bench_query,},
+    { .pattern = "SYSTem:STATistics:RESet", .callback = bench_none,},
+    SCPI_CMD_LIST_END
+};
+
+static size_t output_len;
+
+static size_t SCPI_Write(scpi_t * context, const char * data, size_t len) {
+    (void) context;
+    (void) data;
+
+    output_len += len;
+    return len;
+}
+
+static scpi_result_t SCPI_Flush(scpi_t * context) {
+    (void) context;
+    return SCPI_RES_OK;
+}
+
+static int SCPI_Error(scpi_t * context, int_fast16_t err) {
+    (void) context;
+    (void) err;
+    return 0;
+}
+
+static scpi_result_t SCPI_Control(scpi_t * context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
+    (void) context;
+    (void) ctrl;
+    (void) val;
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_Reset(scpi_t * context) {
+    (void) context;
+    return SCPI_RES_OK;
+}
+
+static scpi_interface_t scpi_interface = {
+    .error = SCPI_Error,
+    .write = SCPI_Write,
+    .control = SCPI_Control,
+    .flush = SCPI_Flush,
+    .reset = SCPI_Reset,
+};
+
+/*
+ * Same sizes as rffe-app/scpi-def.h
+ */
+#define SCPI_INPUT_BUFFER_LENGTH 128
+static char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
+
+#define SCPI_ERROR_QUEUE_SIZE 8
+static scpi_error_t scpi_error_queue_data[SCPI_ERROR_QUEUE_SIZE];
+
+#define SCPI_ERROR_INFO_HEAP_SIZE 64
+static char error_info_heap[SCPI_ERROR_INFO_HEAP_SIZE];
+
+static scpi_t scpi_context;
+
+static void bench_context_init(void) {
+    SCPI_Init(&scpi_context,
+            scpi_commands,
+            &scpi_interface,
+            scpi_units_def,
+            "LNLS", "RFFE", NULL, "bench",
+            scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
+            scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
+#if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
+    SCPI_InitHeap(&scpi_context,
+            error_info_heap, SCPI_ERROR_INFO_HEAP_SIZE);
+#else
+    (void) error_info_heap;
+#endif
+}
+
+/*
+ * Benchmarks: each one runs n operations
+ */
+
+static void input(const char* data, long n) {
+    size_t len = strlen(data);
+
+    for (long i = 0; i < n; i++) {
+        SCPI_Input(&scpi_context, data, len);
+    }
+}
+
+static void bench_input_query(long n) {
+    input("MEASure:TEMPerature:AC?\r\n", n);
+}
+
+static void bench_input_short(long n) {
+    input("MEAS:TEMP:AC?\r\n", n);
+}
+
+/* Last entry of the table, the command search is linear */
+static void bench_input_last(long n) {
+    input("SYSTem:STATistics:RESet\r\n", n);
+}
+
+static void bench_input_set(long n) {
+    input("SET:ATTEnuation 10.5\r\n", n);
+}
+
+/* One op is one command of a polling client session */
+static const char* session[] = {
+    "MEASure:TEMPerature:AC?\r\n",
+    "MEASure:TEMPerature:BD?\r\n",
+    "GET:ATTEnuation?\r\n",
+    "GET:TEMPerature:SETPoint:AC?\r\n",
+    "GET:DAC:OUTput:AC?\r\n",
+    "SET:ATTEnuation 10.5\r\n",
+    "GET:PID:Kc:AC?\r\n",
+    "SYSTem:ERRor?\r\n",
+};
+
+static void bench_input_session(long n) {
+    const int count = sizeof(session) / sizeof(session[0]);
+
+    for (long i = 0; i < n; i++) {
+        SCPI_Input(&scpi_context, session[i % count], strlen(session[i % count]));
+    }
+}
+
+/* Partial writes, as received from a TCP stream */
+static void bench_input_fragmented(long n) {
+    static const char data[] = "MEASure:TEMPerature:AC?\r\n";
+
+    for (long i = 0; i < n; i++) {
+        SCPI_Input(&scpi_context, data, 10);
+        SCPI_Input(&scpi_context, data + 10, 10);
+        SCPI_Input(&scpi_context, data + 20, sizeof(data) - 21);
+    }
+}
+
+/* One op is the whole line (3 commands) */
+static void bench_compound(long n) {
+    input("MEAS:TEMP:AC?;BD?;:GET:ATTE?\r\n", n);
+}
+
+static void bench_compound_common(long n) {
+    input("SET:ATTE 10.5;*OPC?\r\n", n);
+}
+
+/* Unknown header: error pushed, then read back */
+static void bench_input_error(long n) {
+    input("MEAS:TEMP:XY?\r\nSYST:ERR?\r\n", n);
+}
+
+static void bench_match_pattern_long(long n) {
+    int32_t num;
+
+    for (long i = 0; i < n; i++) {
+        sink = matchPattern("TEMPerature", 11, "TEMPERATURE", 11, &num);
+    }
+}
+
+static void bench_match_pattern_short(long n) {
+    for (long i = 0; i < n; i++) {
+        sink = matchPattern("TEMPerature", 11, "temp", 4, NULL);
+    }
+}
+
+static void bench_match_command(long n) {
+    for (long i = 0; i < n; i++) {
+        sink = matchCommand("MEASure:TEMPerature:AC?", "MEAS:TEMP:AC?", 13, NULL, 0, 0);
+    }
+}
+
+static void bench_match_command_optional(long n) {
+    for (long i = 0; i < n; i++) {
+        sink = matchCommand("SYSTem:ERRor[:NEXT]?", "SYST:ERR?", 9, NULL, 0, 0);
+    }
+}
+
+static void bench_match_command_miss(long n) {
+    for (long i = 0; i < n; i++) {
+        sink = matchCommand("GET:ATTEnuation:CALibration:D?", "GET:ATTEnuation:CALibration:A?", 30, NULL, 0, 0);
+    }
+}
+
+static void bench_param_number(long n) {
+    input("SET:DAC:OUTput:AC 1.5\r\n", n);
+}
+
+static void bench_param_number_unit(long n) {
+    input("SET:DAC:OUTput:AC 1500 mV\r\n", n);
+}
+
+static void bench_param_number_special(long n) {
+    input("SET:DAC:OUTput:AC MAX\r\n", n);
+}
+
+static void bench_float_to_str(long n) {
+    char buf[32];
+
+    for (long i = 0; i < n; i++) {
+        sink = SCPI_FloatToStr(25.0625f + (i & 7), buf, sizeof(buf));
+    }
+}
+
+static void bench_double_to_str(long n) {
+    char buf[32];
+
+    for (long i = 0; i < n; i++) {
+        sink = SCPI_DoubleToStr(3.14159265358979 * (i & 7), buf, sizeof(buf));
+    }
+}
+
+static void bench_dtostre(long n) {
+    char buf[32];
+
+    for (long i = 0; i < n; i++) {
+        SCPI_dtostre(1.2345678e-6 * (i & 7), buf, sizeof(buf), 6, 0);
+        sink = buf[0];
+    }
+}
+
+/* One op is a push and a pop */
+static void bench_error_push_pop(long n) {
+    scpi_error_t error;
+
+    for (long i = 0; i < n; i++) {
+        SCPI_ErrorPush(&scpi_context, SCPI_ERROR_UNDEFINED_HEADER);
+        SCPI_ErrorPop(&scpi_context, &error);
+    }
+}
+
+/* With device dependent information: copied to the error queue */
+static void bench_error_push_info(long n) {
+    for (long i = 0; i < n; i++) {
+        SCPI_ErrorPushEx(&scpi_context, SCPI_ERROR_UNDEFINED_HEADER, "MEAS:TEMP:XY?", 0);
+        SCPI_ErrorClear(&scpi_context);
+    }
+}
+
+/* Full queue: every push replaces the last entry with an overflow */
+static void bench_error_overflow(long n) {
+    for (long i = 0; i < SCPI_ERROR_QUEUE_SIZE; i++) {
+        SCPI_ErrorPush(&scpi_context, SCPI_ERROR_UNDEFINED_HEADER);
+    }
+    for (long i = 0; i < n; i++) {
+        SCPI_ErrorPush(&scpi_context, SCPI_ERROR_UNDEFINED_HEADER);
+    }
+    SCPI_ErrorClear(&scpi_context);
+}
+
+struct bench {
+    const char* name;
+    void (*run)(long n);
+};
+
+static const struct bench benchs[] = {
+    { "input_query", bench_input_query },
+    { "input_short", bench_input_short },
+    { "input_last", bench_input_last },
+    { "input_set", bench_input_set },
+    { "input_session", bench_input_session },
+    { "input_fragmented", bench_input_fragmented },
+    { "input_error", bench_input_error },
+    { "compound", bench_compound },
+    { "compound_common", bench_compound_common },
+    { "match_pattern_long", bench_match_pattern_long },
+    { "match_pattern_short", bench_match_pattern_short },
+    { "match_command", bench_match_command },
+    { "match_command_optional", bench_match_command_optional },
+    { "match_command_miss", bench_match_command_miss },
+    { "param_number", bench_param_number },
+    { "param_number_unit", bench_param_number_unit },
+    { "param_number_special", bench_param_number_special },
+    { "float_to_str", bench_float_to_str },
+    { "double_to_str", bench_double_to_str },
+    { "dtostre", bench_dtostre },
+    { "error_push_pop", bench_error_push_pop },
+    { "error_push_info", bench_error_push_info },
+    { "error_overflow", bench_error_overflow },
+};
+
+#define BENCH_COUNT   (sizeof(benchs) / sizeof(benchs[0]))
+#define BENCH_MIN_NS  10000000.0
+#define BENCH_REPEAT  15
+
+struct result {
+    double ns;
+    double allocs;
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Op count for a run of BENCH_MIN_NS
+ */
+static long bench_calibrate(void (*run)(long n)) {
+    long n = 1;
+    double t;
+
+    for (;;) {
+        t = now_ns();
+        run(n);
+        t = now_ns() - t;
+        if (t >= BENCH_MIN_NS || n >= (1L << 30)) {
+            return n;
+        }
+        n = t > 0 ? n * (BENCH_MIN_NS * 1.2 / t) + 1 : n * 10;
+    }
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * BENCH_REPEAT runs: the best one is compared with the baseline, the
+ * median shows how noisy the machine is
+ */
+static void bench_run(const struct bench* b, struct result* r, double* median) {
+    long n = bench_calibrate(b->run);
+    double ns[BENCH_REPEAT];
+    double t;
+
+    r->allocs = 0;
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        long allocs = alloc_count;
+
+        t = now_ns();
+        b->run(n);
+        t = now_ns() - t;
+        ns[i] = t / n;
+        r->allocs = (double) (alloc_count - allocs) / n;
+    }
+
+    qsort(ns, BENCH_REPEAT, sizeof(ns[0]), compare_double);
+    r->ns = ns[0];
+    *median = ns[BENCH_REPEAT / 2];
+}
+
+/*
+ * Baseline file: "name ns_per_op allocs_per_op" lines, '#' comments
+ */
+static int baseline_find(FILE* f, const char* name, struct result* r) {
+    char line[128];
+    char bname[64];
+
+    rewind(f);
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%63s %lf %lf", bname, &r->ns, &r->allocs) == 3 && strcmp(bname, name) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char* name) {
+    printf("Usage: %s [-b baseline] [-w baseline] [-t tolerance] [-s] [filter]\n"
+           "  -b  compare with a baseline, exit status 1 if an op allocates more\n"
+           "  -w  write the results as the new baseline\n"
+           "  -t  allowed ns/op increase in percent (default 25)\n"
+           "  -s  exit status 1 on a ns/op increase as well\n"
+           "  filter: only run the benchmarks whose name contains it\n", name);
+}
+
+int main(int argc, char** argv) {
+    const char* baseline_path = NULL;
+    const char* write_path = NULL;
+    const char* filter = NULL;
+    double tolerance = 25.0;
+    int strict = 0;
+    FILE* baseline = NULL;
+    FILE* out = NULL;
+    int regressions = 0;
+    int slower = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:w:t:sh")) != -1) {
+        switch (opt) {
+            case 'b':
+                baseline_path = optarg;
+                break;
+            case 'w':
+                write_path = optarg;
+                break;
+            case 't':
+                tolerance = atof(optarg);
+                break;
+            case 's':
+                strict = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind < argc) {
+        filter = argv[optind];
+    }
+
+    if (baseline_path != NULL && (baseline = fopen(baseline_path, "r")) == NULL) {
+        perror(baseline_path);
+        return 1;
+    }
+    if (write_path != NULL) {
+        if ((out = fopen(write_path, "w")) == NULL) {
+            perror(write_path);
+            return 1;
+        }
+        fprintf(out, "# libscpi benchmark baseline (test/bench_scpi.c), timings depend on the\n"
+                "# machine: regenerate it with 'make bench-baseline' where 'make bench' runs\n"
+                "# name ns/op allocs/op\n");
+    }
+
+    bench_context_init();
+
+    printf("%-24s %10s %10s %10s", "benchmark", "ns/op", "median", "allocs/op");
+    if (baseline != NULL) {
+        printf(" %10s %8s", "baseline", "change");
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        const struct bench* b = &benchs[i];
+        struct result r, base;
+        double median;
+
+        if (filter != NULL && strstr(b->name, filter) == NULL) {
+            continue;
+        }
+
+        bench_run(b, &r, &median);
+        printf("%-24s %10.1f %10.1f %10.2f", b->name, r.ns, median, r.allocs);
+
+        if (baseline != NULL) {
+            if (baseline_find(baseline, b->name, &base) < 0) {
+                printf(" %10s", "-");
+            } else {
+                double change = 100.0 * (r.ns - base.ns) / base.ns;
+
+                printf(" %10.1f %+7.1f%%", base.ns, change);
+                if (change > tolerance) {
+                    printf("  SLOWER");
+                    slower++;
+                }
+                if (r.allocs > base.allocs + 0.005) {
+                    printf("  ALLOCS %.2f > %.2f", r.allocs, base.allocs);
+                    regressions++;
+                }
+            }
+        }
+        printf("\n");
+
+        if (out != NULL) {
+            fprintf(out, "%-24s %10.1f %10.2f\n", b->name, r.ns, r.allocs);
+        }
+    }
+
+    if (baseline != NULL) {
+        fclose(baseline);
+    }
+    if (out != NULL) {
+        fclose(out);
+    }
+
+    if (slower > 0) {
+        printf("%d operation(s) slower than the baseline%s\n", slower,
+               strict ? "" : " (timings are noisy, -s makes this an error)");
+    }
+    if (regressions > 0) {
+        printf("%d operation(s) allocate more than the baseline\n", regressions);
+    }
+    return (regressions > 0 || (strict && slower > 0)) ? 1 : 0;
+}
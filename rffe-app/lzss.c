@@ -0,0 +1,109 @@
+/****************************************************************************
+ * rffe-app/lzss.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include "lzss.h"
+
+enum lzss_state
+{
+    LZSS_STATE_FLAGS,
+    LZSS_STATE_TOKEN,
+    LZSS_STATE_MATCH,
+};
+
+static void lzss_next_token(struct lzss_decoder* dec)
+{
+    dec->flags >>= 1;
+    if (--dec->flag_bits == 0)
+    {
+        dec->state = LZSS_STATE_FLAGS;
+    }
+    else
+    {
+        dec->state = LZSS_STATE_TOKEN;
+    }
+}
+
+void lzss_init(struct lzss_decoder* dec, lzss_put_t put, lzss_peek_t peek, void* priv)
+{
+    dec->put = put;
+    dec->peek = peek;
+    dec->priv = priv;
+    dec->out_len = 0;
+    dec->state = LZSS_STATE_FLAGS;
+    dec->flags = 0;
+    dec->flag_bits = 0;
+    dec->match_lo = 0;
+}
+
+int lzss_decode(struct lzss_decoder* dec, const uint8_t* in, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t byte = in[i];
+
+        switch (dec->state)
+        {
+        case LZSS_STATE_FLAGS:
+            dec->flags = byte;
+            dec->flag_bits = 8;
+            dec->state = LZSS_STATE_TOKEN;
+            break;
+
+        case LZSS_STATE_TOKEN:
+            if (dec->flags & 1)
+            {
+                dec->match_lo = byte;
+                dec->state = LZSS_STATE_MATCH;
+            }
+            else
+            {
+                if (dec->put(dec->priv, byte) < 0) return -1;
+                dec->out_len++;
+                lzss_next_token(dec);
+            }
+            break;
+
+        case LZSS_STATE_MATCH:
+        {
+            uint32_t distance = (dec->match_lo | (byte & 0xF0) << 4) + 1;
+            uint32_t length = (byte & 0x0F) + LZSS_MIN_LENGTH;
+
+            if (distance > dec->out_len) return -2;
+
+            /*
+             * Byte by byte, so overlapping references (distance <
+             * length) repeat the pattern as expected
+             */
+            for (uint32_t j = 0; j < length; j++)
+            {
+                if (dec->put(dec->priv, dec->peek(dec->priv, distance)) < 0) return -1;
+                dec->out_len++;
+            }
+            lzss_next_token(dec);
+        }
+            break;
+        }
+    }
+
+    return 0;
+}
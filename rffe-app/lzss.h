@@ -0,0 +1,81 @@
+/****************************************************************************
+ * rffe-app/lzss.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef LZSS_H_
+#define LZSS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Streaming LZSS decoder used for compressed firmware images.
+ *
+ * Stream format: a flags byte precedes every group of 8 tokens, read
+ * from the least significant bit. A 0 bit is a literal byte, a 1 bit is
+ * a 2 bytes back-reference:
+ *
+ *   byte 0: (distance - 1) bits 7..0
+ *   byte 1: (distance - 1) bits 11..8 << 4 | (length - 3)
+ *
+ * so distances go from 1 to 4096 bytes and lengths from 3 to 18 bytes.
+ * The decoder keeps no window of its own: back-references are resolved
+ * through the peek callback, which can read the already written output
+ * (e.g. directly from flash).
+ */
+
+#define LZSS_MAX_DISTANCE 4096
+#define LZSS_MIN_LENGTH   3
+#define LZSS_MAX_LENGTH   18
+
+typedef int (*lzss_put_t)(void* priv, uint8_t byte);
+typedef uint8_t (*lzss_peek_t)(void* priv, uint32_t distance);
+
+struct lzss_decoder
+{
+    lzss_put_t put;
+    lzss_peek_t peek;
+    void* priv;
+    uint32_t out_len;
+    uint8_t state;
+    uint8_t flags;
+    uint8_t flag_bits;
+    uint8_t match_lo;
+};
+
+/**
+ * @brief Initialize a LZSS decoder
+ * @param put: Output callback, called once per decoded byte
+ * @param peek: Returns the output byte 'distance' bytes before the
+ * current output position
+ * @param priv: Private data passed to the callbacks
+ */
+void lzss_init(struct lzss_decoder* dec, lzss_put_t put, lzss_peek_t peek, void* priv);
+
+/**
+ * @brief Decode a chunk of compressed data, tokens may span chunks
+ * @return 0 if success, a negative number if the stream is invalid or
+ * the put callback failed
+ */
+int lzss_decode(struct lzss_decoder* dec, const uint8_t* in, size_t len);
+
+#endif
@@ -21,49 +21,18 @@
  *
  ****************************************************************************/
 
+#include <nuttx/config.h>
+#include <stdio.h>
 #include <arpa/inet.h>
 #include "netconfig.h"
 
-int netconfig(char* netdev, struct netifconfig* conf, int use_dhcp)
+int netconfig_link_up(char* netdev, struct netifconfig* conf)
 {
     netlib_setmacaddr(netdev, conf->mac);
     netlib_set_dripv4addr(netdev, &conf->default_router);
     netlib_set_ipv4addr(netdev, &conf->ipaddr);
     netlib_set_ipv4netmask(netdev, &conf->netmask);
-    netlib_ifup(netdev);
-
-    if(use_dhcp)
-    {
-        FAR void *handle;
-        handle = dhcpc_open(netdev, conf->mac, 6);
-
-        if (handle != NULL)
-        {
-            struct dhcpc_state ds;
-            (void)dhcpc_request(handle, &ds);
-            netlib_set_ipv4addr(netdev, &ds.ipaddr);
-
-            conf->ipaddr = ds.ipaddr;
-
-            if (ds.netmask.s_addr != 0)
-            {
-                netlib_set_ipv4netmask(netdev, &ds.netmask);
-                conf->netmask = ds.netmask;
-            }
-
-            if (ds.default_router.s_addr != 0)
-            {
-                netlib_set_dripv4addr(netdev, &ds.default_router);
-                conf->default_router = ds.default_router;
-            }
-            dhcpc_close(handle);
-        }
-        else
-        {
-            return -2;
-        }
-    }
-    return 0;
+    return netlib_ifup(netdev);
 }
 
 void print_netconfig(struct netifconfig* conf)
@@ -38,7 +38,12 @@ struct netifconfig
     struct in_addr default_router;
 };
 
-int netconfig(char* netdev, struct netifconfig* conf, int use_dhcp);
+/**
+ * @brief Set the MAC and static addresses and bring the interface up
+ * @return 0 if success, a negative number otherwise
+ */
+int netconfig_link_up(char* netdev, struct netifconfig* conf);
+
 void print_netconfig(struct netifconfig* conf);
 
 #endif
@@ -0,0 +1,89 @@
+/****************************************************************************
+ * rffe-app/pool.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include "pool.h"
+
+void pool_init(struct pool* pool, void* storage, size_t block_size, uint16_t count)
+{
+    uint8_t* block = storage;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->free = NULL;
+
+    for (int i = count - 1; i >= 0; i--)
+    {
+        *(void**)(block + i * block_size) = pool->free;
+        pool->free = block + i * block_size;
+    }
+
+    pool->stats.capacity = count;
+    pool->stats.in_use = 0;
+    pool->stats.peak = 0;
+    pool->stats.acquired = 0;
+    pool->stats.failures = 0;
+}
+
+void* pool_acquire(struct pool* pool)
+{
+    void* block;
+
+    pthread_mutex_lock(&pool->lock);
+    block = pool->free;
+    if (block == NULL)
+    {
+        pool->stats.failures++;
+    }
+    else
+    {
+        pool->free = *(void**)block;
+        pool->stats.acquired++;
+        pool->stats.in_use++;
+        if (pool->stats.in_use > pool->stats.peak)
+        {
+            pool->stats.peak = pool->stats.in_use;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return block;
+}
+
+void pool_release(struct pool* pool, void* block)
+{
+    pthread_mutex_lock(&pool->lock);
+    *(void**)block = pool->free;
+    pool->free = block;
+    pool->stats.in_use--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_get_stats(struct pool* pool, struct pool_stats* stats)
+{
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
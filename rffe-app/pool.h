@@ -0,0 +1,78 @@
+/****************************************************************************
+ * rffe-app/pool.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/*
+ * Fixed size block pool over a static array: acquire and release are
+ * O(1) (the free blocks form a linked list through their first word)
+ * and never touch the heap, so connection churn can't fragment it.
+ */
+
+struct pool_stats
+{
+    uint16_t capacity;
+    uint16_t in_use;
+    uint16_t peak;
+    uint32_t acquired;
+    uint32_t failures;  /* Acquire calls with no free blocks */
+};
+
+struct pool
+{
+    pthread_mutex_t lock;
+    void* free;
+    struct pool_stats stats;
+};
+
+/**
+ * @brief Initialize a pool
+ * @param storage: Array of count blocks of block_size bytes, aligned
+ * to a pointer
+ * @param block_size: Block size, at least sizeof(void*)
+ * @param count: Number of blocks
+ */
+void pool_init(struct pool* pool, void* storage, size_t block_size, uint16_t count);
+
+/**
+ * @brief Take a block from the pool
+ * @return The block or NULL if the pool is exhausted
+ */
+void* pool_acquire(struct pool* pool);
+
+/**
+ * @brief Return a block to the pool
+ */
+void pool_release(struct pool* pool, void* block);
+
+/**
+ * @brief Read the pool counters
+ */
+void pool_get_stats(struct pool* pool, struct pool_stats* stats);
+
+#endif
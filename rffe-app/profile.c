@@ -0,0 +1,198 @@
+/****************************************************************************
+ * rffe-app/profile.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <string.h>
+
+#include "profile.h"
+
+#ifdef CONFIG_ARCH_CORTEXM3
+
+#include <arch/irq.h>
+#include <arch/board/board.h>
+
+#define DEMCR         (*(volatile uint32_t*)0xE000EDFC)
+#define DEMCR_TRCENA  (1 << 24)
+#define DWT_CTRL      (*(volatile uint32_t*)0xE0001000)
+#define DWT_CYCCNT    (*(volatile uint32_t*)0xE0001004)
+#define DWT_CYCCNTENA (1 << 0)
+
+#define PROFILE_FREQUENCY LPC17_40_CCLK
+#define PROFILE_LOCK()    irqstate_t flags = up_irq_save()
+#define PROFILE_UNLOCK()  up_irq_restore(flags)
+
+static void profile_counter_init(void)
+{
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CYCCNTENA;
+}
+
+uint32_t profile_cycles(void)
+{
+    return DWT_CYCCNT;
+}
+
+#else
+
+#include <time.h>
+#include <pthread.h>
+
+#ifdef CONFIG_EXAMPLES_RFFE_PROFILE
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#define PROFILE_FREQUENCY 1000000000
+#define PROFILE_LOCK()    pthread_mutex_lock(&profile_lock)
+#define PROFILE_UNLOCK()  pthread_mutex_unlock(&profile_lock)
+
+static void profile_counter_init(void)
+{
+}
+
+uint32_t profile_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+#endif
+
+uint32_t profile_frequency(void)
+{
+    return PROFILE_FREQUENCY;
+}
+
+static const char* profile_names[PROFILE_PROBES] =
+{
+    "SCPI_Input",
+    "findCommandHeader",
+    "pid_compute",
+    "sensor_read",
+    "config_read",
+    "dac_write",
+};
+
+const char* profile_probe_name(int probe)
+{
+    return (probe >= 0 && probe < PROFILE_PROBES) ? profile_names[probe] : "";
+}
+
+#ifdef CONFIG_EXAMPLES_RFFE_PROFILE
+
+static struct profile_stats profile_table[PROFILE_PROBES + PROFILE_MAX_COMMANDS];
+
+/*
+ * Cost of an empty PROFILE_START()/PROFILE_STOP() pair, subtracted
+ * from every measurement
+ */
+static uint32_t profile_overhead;
+
+void profile_init(void)
+{
+    uint32_t start;
+
+    profile_counter_init();
+
+    start = profile_cycles();
+    profile_overhead = profile_cycles() - start;
+
+    profile_reset();
+}
+
+void profile_record(int probe, uint32_t cycles)
+{
+    struct profile_stats* stats;
+
+    if (probe < 0 || probe >= PROFILE_PROBES + PROFILE_MAX_COMMANDS)
+    {
+        return;
+    }
+
+    cycles = cycles > profile_overhead ? cycles - profile_overhead : 0;
+    stats = &profile_table[probe];
+
+    PROFILE_LOCK();
+    stats->count++;
+    stats->total += cycles;
+    if (cycles < stats->min) stats->min = cycles;
+    if (cycles > stats->max) stats->max = cycles;
+    PROFILE_UNLOCK();
+}
+
+int profile_get(int probe, struct profile_stats* stats)
+{
+    if (probe < 0 || probe >= PROFILE_PROBES + PROFILE_MAX_COMMANDS)
+    {
+        return -1;
+    }
+
+    PROFILE_LOCK();
+    *stats = profile_table[probe];
+    PROFILE_UNLOCK();
+
+    if (stats->count == 0)
+    {
+        stats->min = 0;
+    }
+    return 0;
+}
+
+void profile_reset(void)
+{
+    PROFILE_LOCK();
+    memset(profile_table, 0, sizeof(profile_table));
+    for (int i = 0; i < PROFILE_PROBES + PROFILE_MAX_COMMANDS; i++)
+    {
+        profile_table[i].min = UINT32_MAX;
+    }
+    PROFILE_UNLOCK();
+}
+
+#else
+
+void profile_init(void)
+{
+    profile_counter_init();
+}
+
+void profile_record(int probe, uint32_t cycles)
+{
+}
+
+int profile_get(int probe, struct profile_stats* stats)
+{
+    return -1;
+}
+
+void profile_reset(void)
+{
+}
+
+#endif
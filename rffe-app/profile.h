@@ -0,0 +1,113 @@
+/****************************************************************************
+ * rffe-app/profile.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <nuttx/config.h>
+#include <stdint.h>
+
+/*
+ * Hot path profiling: PROFILE_START()/PROFILE_STOP() pairs measure the
+ * time spent in a probe, in CPU cycles from the Cortex-M3 DWT cycle
+ * counter (nanoseconds from clock_gettime() on other architectures),
+ * and accumulate count, min, max and total per probe.
+ *
+ * Without CONFIG_EXAMPLES_RFFE_PROFILE the macros expand to nothing,
+ * the cycle counter itself is always available.
+ */
+
+enum profile_probe
+{
+    PROFILE_SCPI_INPUT,
+    PROFILE_SCPI_FIND,
+    PROFILE_PID_COMPUTE,
+    PROFILE_SENSOR_READ,
+    PROFILE_CONFIG_READ,
+    PROFILE_DAC_WRITE,
+    PROFILE_PROBES,
+};
+
+/*
+ * SCPI command callbacks use one probe each, PROFILE_PROBES plus the
+ * index of the command in scpi_commands
+ */
+#define PROFILE_MAX_COMMANDS 80
+#define PROFILE_COMMAND(index) (PROFILE_PROBES + (index))
+
+struct profile_stats
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+};
+
+#ifdef CONFIG_EXAMPLES_RFFE_PROFILE
+#  define PROFILE_START(t)        uint32_t t = profile_cycles()
+#  define PROFILE_STOP(probe, t)  profile_record((probe), profile_cycles() - (t))
+#  define PROFILE_RECORD(probe, cycles) profile_record((probe), (cycles))
+#else
+#  define PROFILE_START(t)
+#  define PROFILE_STOP(probe, t)
+#  define PROFILE_RECORD(probe, cycles)
+#endif
+
+/**
+ * @brief Start the cycle counter and measure the probe overhead
+ */
+void profile_init(void);
+
+/**
+ * @brief Current value of the cycle counter
+ */
+uint32_t profile_cycles(void);
+
+/**
+ * @brief Account a measurement (use the macros instead)
+ */
+void profile_record(int probe, uint32_t cycles);
+
+/**
+ * @brief Cycle counter frequency in Hz
+ */
+uint32_t profile_frequency(void);
+
+/**
+ * @brief Read the statistics of a probe
+ * @return 0 if success, a negative number if the probe doesn't exist
+ * or profiling is disabled
+ */
+int profile_get(int probe, struct profile_stats* stats);
+
+/**
+ * @brief Name of a fixed probe (not for command probes)
+ */
+const char* profile_probe_name(int probe);
+
+/**
+ * @brief Clear the statistics of all probes
+ */
+void profile_reset(void);
+
+#endif
@@ -37,6 +37,9 @@
 
 #include "netconfig.h"
 #include "config_file.h"
+#include "att_cal.h"
+#include "syslog_sink.h"
+#include "stack_monitor.h"
 #include "git_version.h"
 
 static char* cfg_file = "/dev/feram0";
@@ -137,6 +140,20 @@ int rffe_console_cfg(int argc, char *argv[])
             {
                 rffe_console_print_version();
             }
+            else if (strcmp(argv[2], "stack") == 0)
+            {
+                stack_monitor_print();
+            }
+            else if (strcmp(argv[2], "syslog") == 0)
+            {
+                struct syslog_sink_stats stats;
+                syslog_sink_get_stats(&stats);
+
+                printf("Collector: %s:%u\n", inet_ntoa(stats.addr), stats.port);
+                printf("Sent: %lu, rate limited: %lu, errors: %lu, buffer full: %lu\n",
+                       (unsigned long)stats.sent, (unsigned long)stats.rate_dropped,
+                       (unsigned long)stats.errors, (unsigned long)stats.log_dropped);
+            }
 
         }
         else if (strcmp(argv[1], "set") == 0)
@@ -167,11 +184,16 @@ int rffe_console_cfg(int argc, char *argv[])
             }
             else if (strcmp(argv[2], "mac") == 0)
             {
+                unsigned int val[6];
                 uint8_t mac[6];
                 ret = sscanf(argv[3], "%x:%x:%x:%x:%x:%x",
-                             &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+                             &val[0], &val[1], &val[2], &val[3], &val[4], &val[5]);
                 if (ret == 6)
                 {
+                    for (int i = 0; i < 6; i++)
+                    {
+                        mac[i] = val[i];
+                    }
                     config_set_mac_addr(cfg_file, mac);
                 }
                 else
@@ -194,6 +216,28 @@ int rffe_console_cfg(int argc, char *argv[])
                     printf("Expected parameter: [enable | disable]. Received: %s\n", argv[3]);
                 }
             }
+            else if (strcmp(argv[2], "syslog") == 0)
+            {
+                unsigned int port = SYSLOG_SINK_DEFAULT_PORT;
+                char* sep = strchr(argv[3], ':');
+
+                if (sep != NULL)
+                {
+                    *sep = '\0';
+                    sscanf(sep + 1, "%u", &port);
+                }
+
+                int valid_ip = inet_pton(AF_INET, argv[3], &netaddr);
+                if (valid_ip && port > 0 && port < 0xFFFF)
+                {
+                    config_set_syslog_addr(cfg_file, netaddr, htons(port));
+                    syslog_sink_set_collector(netaddr, htons(port));
+                }
+                else
+                {
+                    printf("Expected parameter: <ip>[:port] (0.0.0.0 disables). Received: %s\n", argv[3]);
+                }
+            }
             else if (strcmp(argv[2], "attenuation") == 0)
             {
                 struct attenuator_control att;
@@ -204,9 +248,8 @@ int rffe_console_cfg(int argc, char *argv[])
                 {
                     att.attenuation = ftob16(num);
 
-                    int fd = open("/dev/att0", O_RDONLY);
-                    ioctl(fd, RFIOC_SETATT, (unsigned long)&att);
-                    close(fd);
+                    att_cal_load(cfg_file);
+                    att_cal_apply(att.attenuation);
 
                     config_set_attenuation("/dev/feram0", att.attenuation);
                 }
@@ -0,0 +1,238 @@
+/****************************************************************************
+ * rffe-app/rffe_log.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+#include "rffe_log.h"
+
+#define RFFE_LOG_BUF_SIZE    1024
+#define RFFE_LOG_MSG_MAX     96
+#define RFFE_LOG_MAX_SINKS   2
+#define RFFE_LOG_PRIORITY    40
+#define RFFE_LOG_STACK_SIZE  1536
+
+/*
+ * Each record is a header followed by 'len' bytes of text. Records
+ * may wrap around the end of the buffer. head and tail only grow,
+ * the buffer index is taken modulo RFFE_LOG_BUF_SIZE.
+ */
+struct rffe_log_hdr
+{
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t len;
+};
+
+static uint8_t log_buf[RFFE_LOG_BUF_SIZE];
+static uint32_t log_head, log_tail;
+static uint32_t log_dropped, log_dropped_reported;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t log_sem;
+static int log_started;
+
+static rffe_log_sink_t log_sinks[RFFE_LOG_MAX_SINKS];
+
+static void ring_put(const void* data, size_t len)
+{
+    const uint8_t* src = data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        log_buf[(log_head + i) % RFFE_LOG_BUF_SIZE] = src[i];
+    }
+    log_head += len;
+}
+
+static void ring_get(void* data, size_t len)
+{
+    uint8_t* dst = data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = log_buf[(log_tail + i) % RFFE_LOG_BUF_SIZE];
+    }
+    log_tail += len;
+}
+
+static uint32_t log_time_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+char rffe_log_level_tag(int level)
+{
+    static const char tags[] = "-EWID";
+
+    return (level >= 0 && level < sizeof(tags) - 1) ? tags[level] : '?';
+}
+
+void rffe_log_write(int level, const char* fmt, ...)
+{
+    struct rffe_log_hdr hdr;
+    char msg[RFFE_LOG_MSG_MAX];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    if (n < 0) return;
+    if (n >= sizeof(msg)) n = sizeof(msg) - 1;
+    while (n > 0 && msg[n - 1] == '\n') n--;
+
+    hdr.timestamp = log_time_ms();
+    hdr.level = level;
+    hdr.len = n;
+
+    pthread_mutex_lock(&log_lock);
+    if (RFFE_LOG_BUF_SIZE - (log_head - log_tail) < sizeof(hdr) + n)
+    {
+        log_dropped++;
+        pthread_mutex_unlock(&log_lock);
+        return;
+    }
+    ring_put(&hdr, sizeof(hdr));
+    ring_put(msg, n);
+    pthread_mutex_unlock(&log_lock);
+
+    if (log_started)
+    {
+        sem_post(&log_sem);
+    }
+}
+
+static int log_pop(struct rffe_log_hdr* hdr, char* msg)
+{
+    pthread_mutex_lock(&log_lock);
+    if (log_head == log_tail)
+    {
+        pthread_mutex_unlock(&log_lock);
+        return 0;
+    }
+    ring_get(hdr, sizeof(*hdr));
+    ring_get(msg, hdr->len);
+    msg[hdr->len] = '\0';
+    pthread_mutex_unlock(&log_lock);
+    return 1;
+}
+
+static void log_console_sink(int level, uint32_t timestamp, const char* msg)
+{
+    printf("[%5lu.%03lu] %c %s\n", (unsigned long)(timestamp / 1000),
+           (unsigned long)(timestamp % 1000), rffe_log_level_tag(level), msg);
+}
+
+static void log_dispatch(int level, uint32_t timestamp, const char* msg)
+{
+    log_console_sink(level, timestamp, msg);
+
+    for (int i = 0; i < RFFE_LOG_MAX_SINKS; i++)
+    {
+        if (log_sinks[i] != NULL)
+        {
+            log_sinks[i](level, timestamp, msg);
+        }
+    }
+}
+
+static void* log_task(void* args)
+{
+    struct rffe_log_hdr hdr;
+    char msg[RFFE_LOG_MSG_MAX];
+
+    while (1)
+    {
+        while (log_pop(&hdr, msg))
+        {
+            log_dispatch(hdr.level, hdr.timestamp, msg);
+        }
+
+        uint32_t dropped = log_dropped;
+        if (dropped != log_dropped_reported)
+        {
+            snprintf(msg, sizeof(msg), "%lu log messages dropped",
+                     (unsigned long)(dropped - log_dropped_reported));
+            log_dropped_reported = dropped;
+            log_dispatch(RFFE_LOG_LEVEL_WARN, log_time_ms(), msg);
+        }
+
+        sem_wait(&log_sem);
+    }
+
+    return NULL;
+}
+
+int rffe_log_start(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct sched_param param;
+
+    sem_init(&log_sem, 0, 0);
+    log_started = 1;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, RFFE_LOG_STACK_SIZE);
+    param.sched_priority = RFFE_LOG_PRIORITY;
+    pthread_attr_setschedparam(&attr, &param);
+
+    if (pthread_create(&thread, &attr, &log_task, NULL) != 0)
+    {
+        log_started = 0;
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+int rffe_log_add_sink(rffe_log_sink_t sink)
+{
+    for (int i = 0; i < RFFE_LOG_MAX_SINKS; i++)
+    {
+        if (log_sinks[i] == NULL)
+        {
+            log_sinks[i] = sink;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+uint32_t rffe_log_dropped(void)
+{
+    return log_dropped;
+}
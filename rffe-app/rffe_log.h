@@ -0,0 +1,109 @@
+/****************************************************************************
+ * rffe-app/rffe_log.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef RFFE_LOG_H_
+#define RFFE_LOG_H_
+
+#include <nuttx/config.h>
+#include <stdint.h>
+
+/*
+ * Deferred logger: messages are formatted by the caller into a RAM
+ * ring buffer and written to the sinks (console, ...) by a low
+ * priority task, so request handlers never wait for the 115200 bps
+ * console. When the ring is full new messages are dropped and
+ * counted.
+ *
+ * Messages above CONFIG_EXAMPLES_RFFE_LOG_LEVEL are removed at
+ * compile time.
+ */
+
+#define RFFE_LOG_LEVEL_OFF   0
+#define RFFE_LOG_LEVEL_ERROR 1
+#define RFFE_LOG_LEVEL_WARN  2
+#define RFFE_LOG_LEVEL_INFO  3
+#define RFFE_LOG_LEVEL_DEBUG 4
+
+#ifndef CONFIG_EXAMPLES_RFFE_LOG_LEVEL
+#  define CONFIG_EXAMPLES_RFFE_LOG_LEVEL RFFE_LOG_LEVEL_INFO
+#endif
+
+#if CONFIG_EXAMPLES_RFFE_LOG_LEVEL >= RFFE_LOG_LEVEL_ERROR
+#  define rffe_log_error(...) rffe_log_write(RFFE_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#  define rffe_log_error(...)
+#endif
+
+#if CONFIG_EXAMPLES_RFFE_LOG_LEVEL >= RFFE_LOG_LEVEL_WARN
+#  define rffe_log_warn(...) rffe_log_write(RFFE_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#  define rffe_log_warn(...)
+#endif
+
+#if CONFIG_EXAMPLES_RFFE_LOG_LEVEL >= RFFE_LOG_LEVEL_INFO
+#  define rffe_log_info(...) rffe_log_write(RFFE_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#  define rffe_log_info(...)
+#endif
+
+#if CONFIG_EXAMPLES_RFFE_LOG_LEVEL >= RFFE_LOG_LEVEL_DEBUG
+#  define rffe_log_debug(...) rffe_log_write(RFFE_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#  define rffe_log_debug(...)
+#endif
+
+/*
+ * Sink callback: level, milliseconds since boot and the message
+ * (without trailing newline)
+ */
+typedef void (*rffe_log_sink_t)(int level, uint32_t timestamp, const char* msg);
+
+/**
+ * @brief Start the task that drains the log buffer. Messages logged
+ * before are kept and written once it starts.
+ * @return 0 if success, a negative number otherwise
+ */
+int rffe_log_start(void);
+
+/**
+ * @brief Queue a message, use the rffe_log_<level>() macros instead
+ */
+void rffe_log_write(int level, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+/**
+ * @brief Register an additional sink (the console is always used)
+ * @return 0 if success, a negative number if there are no free slots
+ */
+int rffe_log_add_sink(rffe_log_sink_t sink);
+
+/**
+ * @brief Number of messages dropped because the buffer was full
+ */
+uint32_t rffe_log_dropped(void);
+
+/**
+ * @brief Single letter tag of a level ('E', 'W', 'I' or 'D')
+ */
+char rffe_log_level_tag(int level);
+
+#endif
@@ -45,12 +45,42 @@
 #include "scpi_server.h"
 #include "config_file_migrate.h"
 #include "config_file.h"
+#include "att_cal.h"
 #include "rffe_console_cfg.h"
 #include "fw_update.h"
 #include "temp_control.h"
+#include "boot_time.h"
+#include "dhcp_lease.h"
+#include "discovery.h"
+#include "syslog_sink.h"
+#include "svc_loop.h"
+#include "profile.h"
+#include "rffe_log.h"
+
+#define NSH_STACK_SIZE 2048
 
 static const char* cfg_file = "/dev/feram0";
 
+static struct netifconfig net_conf;
+
+static void status_led_set(int val)
+{
+    int ledfd = open("/dev/statusleds", O_WRONLY);
+    ioctl(ledfd, ULEDIOC_SETALL, val);
+    close(ledfd);
+}
+
+/*
+ * Called by the DHCP lease manager once the interface gets its first
+ * address (lease or static fallback)
+ */
+static void network_configured(void)
+{
+    boot_time_mark(BOOT_STAGE_NETWORK);
+    status_led_set(0x00);
+    boot_time_print();
+}
+
 #if !defined(BUILD_MODULE)
 int rffe_main(int argc, char *argv[]);
 
@@ -73,12 +103,10 @@ int rffe_startup(int argc, char* argv[])
 
     nsh_initialize();
 
-    int ledfd = open("/dev/statusleds", O_WRONLY);
-    ioctl(ledfd, ULEDIOC_SETALL, 0x01);
-    close(ledfd);
+    status_led_set(0x01);
 
     nsh_telnetstart(AF_INET);
-    task_create("nsh", 100, 2048, nsh_consolemain, nsh_argv);
+    task_create("nsh", 100, NSH_STACK_SIZE, nsh_consolemain, nsh_argv);
 
     /*
      * Migrate the FeRAM contents to the last format if necessary
@@ -100,18 +128,17 @@ int rffe_main(int argc, char *argv[])
 #endif
 {
     int ret;
-    struct netifconfig conf;
     eth_addr_mode_t dhcp;
     struct attenuator_control att;
-    int attfd;
 
     /*
      * dac_ac and dac_bd are shared between the temperature control
      * server and scpi server to allow tracking of the actual DAC
-     * output value (the DAC is write-only)
+     * output value (the DAC is write-only). Static, since the
+     * temperature control starts before anything can fail here.
      */
-    float dac_ac = 0.0;
-    float dac_bd = 0.0;
+    static float dac_ac = 0.0;
+    static float dac_bd = 0.0;
 
     /*
      * If there are arguments to be read, call rffe_console_cfg. This
@@ -129,13 +156,35 @@ int rffe_main(int argc, char *argv[])
     rffe_console_print_version();
 
     /*
-     * Restore previous RF attenuation level
+     * Hot path profiling counters (no-op unless
+     * CONFIG_EXAMPLES_RFFE_PROFILE)
+     */
+    profile_init();
+
+    /*
+     * Deferred logger, used by the servers started below
      */
+    rffe_log_start();
+
+    /*
+     * Restore previous RF attenuation level, corrected by the
+     * attenuator calibration tables
+     */
+    if (att_cal_load(cfg_file) < 0)
+    {
+        printf("WARNING: invalid attenuator calibration, using identity tables\n");
+    }
     config_get_attenuation(cfg_file, &att.attenuation);
     printf("RF attenuation level: %.1f dB\n", b16tof(att.attenuation));
-    attfd = open("/dev/att0", O_RDONLY);
-    ioctl(attfd, RFIOC_SETATT, (unsigned long)&att);
-    close(attfd);
+    att_cal_apply(att.attenuation);
+    boot_time_mark(BOOT_STAGE_ATTENUATION);
+
+    /*
+     * Temperature control server, started before the network so the
+     * heaters are controlled from the beginning
+     */
+    start_temp_control_server(&dac_ac, &dac_bd);
+    boot_time_mark(BOOT_STAGE_TEMP_CONTROL);
 
     /*
      * Initialize the ethernet PHY PLL (50MHz)
@@ -148,50 +197,64 @@ int rffe_main(int argc, char *argv[])
     }
 
     /*
-     * Get the network configuration from the FeRAM
+     * Get the network configuration from the FeRAM and bring the
+     * interface up with the static addresses
      */
-    config_get_mac_addr(cfg_file, conf.mac);
-    config_get_ipv4_addr(cfg_file, &conf.ipaddr.s_addr);
-    config_get_mask_addr(cfg_file, &conf.netmask.s_addr);
-    config_get_gateway_addr(cfg_file, &conf.default_router.s_addr);
-    conf.dnsaddr.s_addr = 0;
+    config_get_mac_addr(cfg_file, net_conf.mac);
+    config_get_ipv4_addr(cfg_file, &net_conf.ipaddr.s_addr);
+    config_get_mask_addr(cfg_file, &net_conf.netmask.s_addr);
+    config_get_gateway_addr(cfg_file, &net_conf.default_router.s_addr);
+    net_conf.dnsaddr.s_addr = 0;
 
     config_get_eth_addressing(cfg_file, &dhcp);
 
+    netconfig_link_up("eth0", &net_conf);
+    boot_time_mark(BOOT_STAGE_LINK_UP);
+
     if (dhcp == ETH_ADDR_MODE_STATIC)
     {
         printf("Configuring network (static ip)...\n");
-
-        /*
-         * Configure the network interface, static IP
-         */
-        netconfig("eth0", &conf, 0);
+        boot_time_mark(BOOT_STAGE_NETWORK);
+        print_netconfig(&net_conf);
+        status_led_set(0x00);
     }
     else
     {
-        printf("Configuring network (dhcp)...\n");
-
-        /*
-         * Configure the network interface, use DHCP
-         */
-        netconfig("eth0", &conf, 1);
+        printf("Configuring network (dhcp, in background)...\n");
+        dhcp_lease_start("eth0", &net_conf, network_configured);
     }
 
-    print_netconfig(&conf);
+    /*
+     * The listeners are bound to INADDR_ANY, they can start as soon as
+     * the link is up and keep working when DHCP changes the address
+     *
+     * Firmware update server
+     */
+    start_fw_update_server();
 
-    int ledfd = open("/dev/statusleds", O_WRONLY);
-    ioctl(ledfd, ULEDIOC_SETALL, 0x00);
-    close(ledfd);
+    /*
+     * UDP discovery responder
+     */
+    start_discovery_server();
 
+#ifdef CONFIG_EXAMPLES_RFFE_SHARED_SERVICES
     /*
-     * Temperature control server
+     * Both listeners above only registered their sockets
      */
-    start_temp_control_server(&dac_ac, &dac_bd);
+    svc_loop_start();
+#endif
 
     /*
-     * Firmware update server
+     * Remote syslog, messages sent before the address is configured
+     * are counted as errors
      */
-    start_fw_update_server();
+    syslog_sink_start();
+    boot_time_mark(BOOT_STAGE_LISTENERS);
+
+    if (dhcp == ETH_ADDR_MODE_STATIC)
+    {
+        boot_time_print();
+    }
 
     /*
      * Initialize the RFFE scpi server
@@ -32,7 +32,7 @@
 #include "scpi/scpi.h"
 #include "git_version.h"
 
-#define SCPI_INPUT_BUFFER_LENGTH 64
+#define SCPI_INPUT_BUFFER_LENGTH 128
 #define SCPI_ERROR_QUEUE_SIZE 8
 #define SCPI_IDN1 "CNPEM LNLS"
 #define SCPI_IDN2 "RFFE"
@@ -21,8 +21,10 @@
  *
  ****************************************************************************/
 #include <stdio.h>
+#include <unistd.h>
 
 #include "scpi_interface.h"
+#include "rffe_log.h"
 
 size_t SCPI_Write(scpi_t * context, const char * data, size_t len)
 {
@@ -32,7 +34,7 @@ size_t SCPI_Write(scpi_t * context, const char * data, size_t len)
 
 int SCPI_Error(scpi_t * context, int_fast16_t err)
 {
-    printf("RFFE SCPI **ERROR: %ld, \"%s\"\n", (int32_t) err, SCPI_ErrorTranslate(err));
+    rffe_log_warn("RFFE SCPI **ERROR: %ld, \"%s\"", (long) err, SCPI_ErrorTranslate(err));
     return 0;
 }
 
@@ -57,6 +59,6 @@ scpi_result_t SCPI_Reset(scpi_t * context)
 	/*
 	 * Reset not implemented
 	 */
-    printf("RFFE SCPI **Reset\n");
+    rffe_log_info("RFFE SCPI **Reset");
     return SCPI_RES_OK;
 }
@@ -30,7 +30,6 @@
 typedef struct
 {
     int sockfd;
-    int* active_threads;
     float* dac_ac;
     float* dac_bd;
 } user_data_t;
@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <fixedmath.h>
 #include <string.h>
+#include <stdio.h>
 
 #include <netinet/in.h>
 #include <sys/boardctl.h>
@@ -36,6 +37,15 @@
 #include "scpi_rffe_cmd.h"
 #include "scpi_interface.h"
 #include "config_file.h"
+#include "att_cal.h"
+#include "boot_time.h"
+#include "dhcp_lease.h"
+#include "syslog_sink.h"
+#include "stack_monitor.h"
+#include "scpi_server.h"
+#include "scpi_tables.h"
+#include "profile.h"
+#include "cmd_stats.h"
 #include "git_version.h"
 
 static const char* cfg_file = "/dev/feram0";
@@ -100,9 +110,7 @@ scpi_result_t rffe_set_attenuation(scpi_t* context)
     {
         att.attenuation = ftob16(par.content.value);
 
-        int fd = open("/dev/att0", O_RDONLY);
-        ioctl(fd, RFIOC_SETATT, (unsigned long)&att);
-        close(fd);
+        att_cal_apply(att.attenuation);
 
         config_set_attenuation(cfg_file, att.attenuation);
     }
@@ -120,6 +128,92 @@ scpi_result_t rffe_get_attenuation(scpi_t* context)
     return SCPI_RES_OK;
 }
 
+/*
+ * The calibration table is sent as a 64 bytes arbitrary block
+ * (#264<data>), one hardware code per 0.5 dB step
+ */
+static scpi_result_t rffe_set_att_cal(scpi_t* context, int channel)
+{
+    const char* data;
+    size_t len;
+    b16_t att;
+
+    if (!SCPI_ParamArbitraryBlock(context, &data, &len, TRUE))
+    {
+        return SCPI_RES_ERR;
+    }
+
+    if (len != ATT_CAL_ENTRIES)
+    {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    if (att_cal_set_table(cfg_file, channel, (const uint8_t*)data) < 0)
+    {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    /*
+     * Re-apply the current attenuation with the new table
+     */
+    config_get_attenuation(cfg_file, &att);
+    att_cal_apply(att);
+
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t rffe_get_att_cal(scpi_t* context, int channel)
+{
+    uint8_t table[ATT_CAL_ENTRIES];
+
+    att_cal_get_table(channel, table);
+    SCPI_ResultArbitraryBlock(context, table, ATT_CAL_ENTRIES);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t rffe_set_att_cal_a(scpi_t* context)
+{
+    return rffe_set_att_cal(context, 0);
+}
+
+scpi_result_t rffe_set_att_cal_b(scpi_t* context)
+{
+    return rffe_set_att_cal(context, 1);
+}
+
+scpi_result_t rffe_set_att_cal_c(scpi_t* context)
+{
+    return rffe_set_att_cal(context, 2);
+}
+
+scpi_result_t rffe_set_att_cal_d(scpi_t* context)
+{
+    return rffe_set_att_cal(context, 3);
+}
+
+scpi_result_t rffe_get_att_cal_a(scpi_t* context)
+{
+    return rffe_get_att_cal(context, 0);
+}
+
+scpi_result_t rffe_get_att_cal_b(scpi_t* context)
+{
+    return rffe_get_att_cal(context, 1);
+}
+
+scpi_result_t rffe_get_att_cal_c(scpi_t* context)
+{
+    return rffe_get_att_cal(context, 2);
+}
+
+scpi_result_t rffe_get_att_cal_d(scpi_t* context)
+{
+    return rffe_get_att_cal(context, 3);
+}
+
 scpi_result_t rffe_self_test(scpi_t* context)
 {
 
@@ -645,6 +739,94 @@ scpi_result_t rffe_get_dhcp_mode(scpi_t* context)
     return SCPI_RES_OK;
 }
 
+/*
+ * DHCP lease state: state name, leased (or fallback) address, DHCP
+ * server, lease time (s), remaining lease time (s), renewals and
+ * failed requests
+ */
+scpi_result_t rffe_get_dhcp_lease(scpi_t* context)
+{
+    struct dhcp_lease_info info;
+    const char* str;
+
+    dhcp_lease_get_info(&info);
+
+    str = dhcp_lease_state_name(info.state);
+    SCPI_ResultCharacters(context, str, strlen(str));
+    str = inet_ntoa(info.ipaddr);
+    SCPI_ResultCharacters(context, str, strlen(str));
+    str = inet_ntoa(info.server);
+    SCPI_ResultCharacters(context, str, strlen(str));
+    SCPI_ResultUInt32(context, info.lease_time);
+    SCPI_ResultUInt32(context, info.remaining);
+    SCPI_ResultUInt32(context, info.renewals);
+    SCPI_ResultUInt32(context, info.failures);
+
+    return SCPI_RES_OK;
+}
+
+/*
+ * Collector as "a.b.c.d[:port]", "0.0.0.0" disables log shipping.
+ * Saved to the FeRAM and applied immediately.
+ */
+scpi_result_t rffe_set_syslog(scpi_t* context)
+{
+    char buf[32];
+    size_t copy_len;
+    in_addr_t addr;
+    unsigned int port = SYSLOG_SINK_DEFAULT_PORT;
+    char* sep;
+
+    if (!SCPI_ParamCopyText(context, buf, sizeof (buf), &copy_len, TRUE))
+    {
+        return SCPI_RES_ERR;
+    }
+
+    sep = strchr(buf, ':');
+    if (sep != NULL)
+    {
+        *sep = '\0';
+        if (sscanf(sep + 1, "%u", &port) != 1 || port == 0 || port > 0xFFFE)
+        {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    if (inet_pton(AF_INET, buf, &addr) != 1 || addr == INADDR_NONE)
+    {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    config_set_syslog_addr(cfg_file, addr, htons(port));
+    syslog_sink_set_collector(addr, htons(port));
+
+    return SCPI_RES_OK;
+}
+
+/*
+ * Collector address, port, messages sent, dropped by the rate
+ * limiter, send errors and messages dropped by the log buffer
+ */
+scpi_result_t rffe_get_syslog(scpi_t* context)
+{
+    struct syslog_sink_stats stats;
+    const char* str;
+
+    syslog_sink_get_stats(&stats);
+
+    str = inet_ntoa(stats.addr);
+    SCPI_ResultCharacters(context, str, strlen(str));
+    SCPI_ResultUInt32(context, stats.port);
+    SCPI_ResultUInt32(context, stats.sent);
+    SCPI_ResultUInt32(context, stats.rate_dropped);
+    SCPI_ResultUInt32(context, stats.errors);
+    SCPI_ResultUInt32(context, stats.log_dropped);
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t rffe_get_version(scpi_t* context)
 {
     SCPI_ResultCharacters(context, APPS_GIT_HASH, strlen(APPS_GIT_HASH));
@@ -660,3 +842,169 @@ scpi_result_t rffe_reset(scpi_t* context)
 
     return SCPI_RES_OK;
 }
+
+/*
+ * Milliseconds since boot at which each startup stage completed
+ * (attenuation, temperature control, link up, listeners, network
+ * configured), -1 for stages not reached yet
+ */
+scpi_result_t rffe_get_boot_time(scpi_t* context)
+{
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        SCPI_ResultInt32(context, boot_time_get(i));
+    }
+
+    return SCPI_RES_OK;
+}
+
+static void rffe_stack_result(const struct stack_info* info, void* arg)
+{
+    scpi_t* context = arg;
+    const char* status = stack_monitor_status_name(stack_monitor_status(info));
+
+    SCPI_ResultCharacters(context, info->name, strlen(info->name));
+    SCPI_ResultInt32(context, info->pid);
+    SCPI_ResultUInt32(context, info->size);
+    SCPI_ResultUInt32(context, info->used);
+    SCPI_ResultInt32(context, info->size - info->used);
+    SCPI_ResultCharacters(context, status, strlen(status));
+}
+
+/*
+ * Name, PID, stack size, high-water mark, free bytes and status
+ * (OK, LOW, OVERFLOW or UNKNOWN) of every task
+ */
+scpi_result_t rffe_get_stack(scpi_t* context)
+{
+    stack_monitor_foreach(rffe_stack_result, context);
+
+    return SCPI_RES_OK;
+}
+
+/*
+ * SCPI client context pool: capacity, contexts in use, peak, total
+ * connections accepted and connections rejected for lack of contexts
+ */
+scpi_result_t rffe_get_pool(scpi_t* context)
+{
+    struct pool_stats stats;
+
+    scpi_server_get_pool_stats(&stats);
+
+    SCPI_ResultUInt32(context, stats.capacity);
+    SCPI_ResultUInt32(context, stats.in_use);
+    SCPI_ResultUInt32(context, stats.peak);
+    SCPI_ResultUInt32(context, stats.acquired);
+    SCPI_ResultUInt32(context, stats.failures);
+
+    return SCPI_RES_OK;
+}
+
+static void rffe_profile_result(scpi_t* context, const char* name,
+                                const struct profile_stats* stats)
+{
+    SCPI_ResultCharacters(context, name, strlen(name));
+    SCPI_ResultUInt32(context, stats->count);
+    SCPI_ResultUInt32(context, stats->min);
+    SCPI_ResultUInt32(context, stats->max);
+    SCPI_ResultUInt64(context, stats->total);
+}
+
+/*
+ * Counter frequency (Hz), then name, count, min, max and total cycles
+ * of each hot path probe and of each SCPI command executed at least
+ * once. Fails if the firmware was built without
+ * CONFIG_EXAMPLES_RFFE_PROFILE
+ */
+scpi_result_t rffe_get_profile(scpi_t* context)
+{
+    struct profile_stats stats;
+
+    if (profile_get(0, &stats) < 0)
+    {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultUInt32(context, profile_frequency());
+
+    for (int i = 0; i < PROFILE_PROBES; i++)
+    {
+        profile_get(i, &stats);
+        rffe_profile_result(context, profile_probe_name(i), &stats);
+    }
+
+    for (int i = 0; i < PROFILE_MAX_COMMANDS && scpi_commands[i].pattern != NULL; i++)
+    {
+        if (profile_get(PROFILE_COMMAND(i), &stats) == 0 && stats.count > 0)
+        {
+            rffe_profile_result(context, scpi_commands[i].pattern, &stats);
+        }
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t rffe_reset_profile(scpi_t* context)
+{
+    profile_reset();
+
+    return SCPI_RES_OK;
+}
+
+/*
+ * Per command invocation and error counters and latency histograms,
+ * as a binary block (format in cmd_stats.h). The block has no records
+ * if the firmware was built without CONFIG_EXAMPLES_RFFE_CMD_STATS
+ */
+scpi_result_t rffe_get_statistics(scpi_t* context)
+{
+    struct cmd_stats_header header;
+    struct cmd_stats_record record;
+    struct cmd_stats stats;
+    uint8_t used[CMD_STATS_MAX_COMMANDS];
+    size_t len = sizeof(header);
+    int records = 0;
+
+    /*
+     * Select the commands first, the block length must be known before
+     * sending the data
+     */
+    for (int i = 0; i < CMD_STATS_MAX_COMMANDS && scpi_commands[i].pattern != NULL; i++)
+    {
+        if (cmd_stats_get(i, &stats) == 0 && stats.count > 0)
+        {
+            used[records++] = i;
+            len += sizeof(record) + strlen(scpi_commands[i].pattern) + sizeof(stats);
+        }
+    }
+
+    header.version = CMD_STATS_FORMAT_VERSION;
+    header.buckets = CMD_STATS_BUCKETS;
+    header.records = records;
+
+    SCPI_ResultArbitraryBlockHeader(context, len);
+    SCPI_ResultArbitraryBlockData(context, &header, sizeof(header));
+
+    for (int i = 0; i < records; i++)
+    {
+        const char* name = scpi_commands[used[i]].pattern;
+
+        record.index = used[i];
+        record.name_len = strlen(name);
+        cmd_stats_get(used[i], &stats);
+
+        SCPI_ResultArbitraryBlockData(context, &record, sizeof(record));
+        SCPI_ResultArbitraryBlockData(context, name, record.name_len);
+        SCPI_ResultArbitraryBlockData(context, &stats, sizeof(stats));
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t rffe_reset_statistics(scpi_t* context)
+{
+    cmd_stats_reset();
+
+    return SCPI_RES_OK;
+}
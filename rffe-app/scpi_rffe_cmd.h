@@ -31,6 +31,14 @@ scpi_result_t rffe_measure_temp_ac(scpi_t* context);
 scpi_result_t rffe_measure_temp_bd(scpi_t* context);
 scpi_result_t rffe_set_attenuation(scpi_t* context);
 scpi_result_t rffe_get_attenuation(scpi_t* context);
+scpi_result_t rffe_set_att_cal_a(scpi_t* context);
+scpi_result_t rffe_set_att_cal_b(scpi_t* context);
+scpi_result_t rffe_set_att_cal_c(scpi_t* context);
+scpi_result_t rffe_set_att_cal_d(scpi_t* context);
+scpi_result_t rffe_get_att_cal_a(scpi_t* context);
+scpi_result_t rffe_get_att_cal_b(scpi_t* context);
+scpi_result_t rffe_get_att_cal_c(scpi_t* context);
+scpi_result_t rffe_get_att_cal_d(scpi_t* context);
 scpi_result_t rffe_self_test(scpi_t* context);
 scpi_result_t rffe_set_temp_ac(scpi_t* context);
 scpi_result_t rffe_set_temp_bd(scpi_t* context);
@@ -62,6 +70,16 @@ scpi_result_t rffe_set_netmask(scpi_t* context);
 scpi_result_t rffe_get_netmask(scpi_t* context);
 scpi_result_t rffe_set_dhcp_mode(scpi_t* context);
 scpi_result_t rffe_get_dhcp_mode(scpi_t* context);
+scpi_result_t rffe_get_dhcp_lease(scpi_t* context);
+scpi_result_t rffe_set_syslog(scpi_t* context);
+scpi_result_t rffe_get_syslog(scpi_t* context);
 scpi_result_t rffe_get_version(scpi_t* context);
 scpi_result_t rffe_reset(scpi_t* context);
+scpi_result_t rffe_get_boot_time(scpi_t* context);
+scpi_result_t rffe_get_stack(scpi_t* context);
+scpi_result_t rffe_get_pool(scpi_t* context);
+scpi_result_t rffe_get_profile(scpi_t* context);
+scpi_result_t rffe_reset_profile(scpi_t* context);
+scpi_result_t rffe_get_statistics(scpi_t* context);
+scpi_result_t rffe_reset_statistics(scpi_t* context);
 #endif
@@ -35,7 +35,6 @@
 #include <nuttx/leds/userled.h>
 
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 
@@ -45,36 +44,54 @@
 #include "scpi_interface.h"
 #include "scpi_rffe_cmd.h"
 #include "scpi_tables.h"
-
-static void* handle_client(void* args)
+#include "rffe_log.h"
+#include "pool.h"
+#include "profile.h"
+
+#define SCPI_CLIENT_STACK_SIZE 1344
+#define SCPI_MAX_CLIENTS       4
+
+/*
+ * Everything a connection needs besides its stack, kept in a static
+ * pool instead of the heap and the thread stack
+ */
+struct scpi_client
 {
-    user_data_t* context = (user_data_t*)args;
-    int sockfd = context->sockfd;
-    int* active_threads = context->active_threads;
-    char tcp_buff[16];
-    scpi_error_t scpi_error_queue_data[SCPI_ERROR_QUEUE_SIZE];
-    char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
+    user_data_t user;
     scpi_t scpi_context;
-    pthread_mutex_t counter_lock;
+    char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
+    scpi_error_t scpi_error_queue_data[SCPI_ERROR_QUEUE_SIZE];
+};
+
+static struct scpi_client client_storage[SCPI_MAX_CLIENTS];
+static struct pool client_pool;
 
+static void set_status_led(int val)
+{
     int ledfd = open("/dev/statusleds", O_WRONLY);
-    ioctl(ledfd, ULEDIOC_SETALL, 0x02);
+    ioctl(ledfd, ULEDIOC_SETALL, val);
     close(ledfd);
+}
 
-    pthread_mutex_lock(&counter_lock);
-    (*active_threads)++;
-    pthread_mutex_unlock(&counter_lock);
+static void* handle_client(void* args)
+{
+    struct scpi_client* client = (struct scpi_client*)args;
+    int sockfd = client->user.sockfd;
+    char tcp_buff[16];
+    struct pool_stats stats;
+
+    set_status_led(0x02);
 
     /* user_context will be pointer to socket */
-    SCPI_Init(&scpi_context,
+    SCPI_Init(&client->scpi_context,
               scpi_commands,
               &scpi_interface,
               scpi_units_def,
               SCPI_IDN1, SCPI_IDN2, SCPI_IDN3, SCPI_IDN4,
-              scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
-              scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
+              client->scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
+              client->scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
 
-    scpi_context.user_context = context;
+    client->scpi_context.user_context = &client->user;
 
     while(1)
     {
@@ -82,45 +99,49 @@ static void* handle_client(void* args)
 
         if (n == 0)
         {
-            printf("Thread %d, connection closed\n", sockfd);
+            rffe_log_info("Thread %d, connection closed", sockfd);
             break;
         }
         else if (n < 0)
         {
-            printf("Thread %d, connection error (%d)\n", sockfd, n);
+            rffe_log_warn("Thread %d, connection error (%d)", sockfd, n);
             break;
         }
-        SCPI_Input(&scpi_context, tcp_buff, n);
+        PROFILE_START(start);
+        SCPI_Input(&client->scpi_context, tcp_buff, n);
+        PROFILE_STOP(PROFILE_SCPI_INPUT, start);
     }
 
     close(sockfd);
 
     /*
-     * Free client context
+     * Return the client context to the pool
      */
-    free(context);
+    pool_release(&client_pool, client);
 
-    pthread_mutex_lock(&counter_lock);
-    (*active_threads)--;
-    if (*active_threads < 1)
+    pool_get_stats(&client_pool, &stats);
+    if (stats.in_use < 1)
     {
-        ledfd = open("/dev/statusleds", O_WRONLY);
-        ioctl(ledfd, ULEDIOC_SETALL, 0x00);
-        close(ledfd);
+        set_status_led(0x00);
     }
-    pthread_mutex_unlock(&counter_lock);
     return NULL;
 }
 
+void scpi_server_get_pool_stats(struct pool_stats* stats)
+{
+    pool_get_stats(&client_pool, stats);
+}
+
 int scpi_server_start(float* dac_ac, float* dac_bd)
 {
     int sockfd, newsockfd;
-    int active_threads = 0;
     int ret;
     socklen_t clilen;
     struct sockaddr_in serv_addr, cli_addr;
     pthread_t thread;
 
+    pool_init(&client_pool, client_storage, sizeof(struct scpi_client), SCPI_MAX_CLIENTS);
+
     /*
      * Open a socket
      */
@@ -168,32 +189,42 @@ int scpi_server_start(float* dac_ac, float* dac_bd)
 
         if (ret < 0)
         {
-            fprintf(stderr, "setsockopt(SO_RCVTIMEO) failed: %d\n", ret);
+            rffe_log_error("setsockopt(SO_RCVTIMEO) failed: %d", ret);
         }
 
         if (ret < 0)
         {
-            fprintf(stderr, "setsockopt(SO_KEEPALIVE) failed: %d\n", ret);
+            rffe_log_error("setsockopt(SO_KEEPALIVE) failed: %d", ret);
         }
 
-        if (active_threads < 4)
+        /*
+         * The slot is taken here, not by the client thread, so a burst
+         * of connections can't exceed SCPI_MAX_CLIENTS
+         */
+        struct scpi_client* client = pool_acquire(&client_pool);
+
+        if (client != NULL)
         {
-            user_data_t* ccontext = malloc(sizeof(user_data_t));
-            ccontext->active_threads = &active_threads;
-            ccontext->sockfd = newsockfd;
-            ccontext->dac_ac = dac_ac;
-            ccontext->dac_bd = dac_bd;
+            client->user.sockfd = newsockfd;
+            client->user.dac_ac = dac_ac;
+            client->user.dac_bd = dac_bd;
 
             pthread_attr_t attr;
             pthread_attr_init(&attr);
-            pthread_attr_setstacksize(&attr, 1280);
-            printf("New connection!\n");
-            pthread_create(&thread, &attr, &handle_client, ccontext);
+            pthread_attr_setstacksize(&attr, SCPI_CLIENT_STACK_SIZE);
+            rffe_log_info("New connection!");
+            if (pthread_create(&thread, &attr, &handle_client, client) != 0)
+            {
+                rffe_log_error("Failed to start the client thread");
+                pool_release(&client_pool, client);
+                close(newsockfd);
+                continue;
+            }
             pthread_detach(thread);
         }
         else
         {
-            printf("Connection rejected, maximum active connections reached!\n");
+            rffe_log_warn("Connection rejected, maximum active connections reached!");
             close(newsockfd);
         }
     }
@@ -24,6 +24,14 @@
 #ifndef SCPI_SERVER_H_
 #define SCPI_SERVER_H_
 
+#include "pool.h"
+
 int scpi_server_start(float* dac_ac, float* dac_bd);
 
+/**
+ * @brief Read the occupancy and failure counters of the client
+ * context pool
+ */
+void scpi_server_get_pool_stats(struct pool_stats* stats);
+
 #endif
@@ -58,6 +58,14 @@ const scpi_command_t scpi_commands[] =
     {.pattern = "MEASure:TEMPerature:BD?", .callback = rffe_measure_temp_bd,},
     {.pattern = "SET:ATTEnuation", .callback = rffe_set_attenuation,},
     {.pattern = "GET:ATTEnuation?", .callback = rffe_get_attenuation,},
+    {.pattern = "SET:ATTEnuation:CALibration:A", .callback = rffe_set_att_cal_a,},
+    {.pattern = "SET:ATTEnuation:CALibration:B", .callback = rffe_set_att_cal_b,},
+    {.pattern = "SET:ATTEnuation:CALibration:C", .callback = rffe_set_att_cal_c,},
+    {.pattern = "SET:ATTEnuation:CALibration:D", .callback = rffe_set_att_cal_d,},
+    {.pattern = "GET:ATTEnuation:CALibration:A?", .callback = rffe_get_att_cal_a,},
+    {.pattern = "GET:ATTEnuation:CALibration:B?", .callback = rffe_get_att_cal_b,},
+    {.pattern = "GET:ATTEnuation:CALibration:C?", .callback = rffe_get_att_cal_c,},
+    {.pattern = "GET:ATTEnuation:CALibration:D?", .callback = rffe_get_att_cal_d,},
     {.pattern = "SET:TEMPerature:SETPoint:AC", .callback = rffe_set_temp_ac,},
     {.pattern = "SET:TEMPerature:SETPoint:BD", .callback = rffe_set_temp_bd,},
     {.pattern = "GET:TEMPerature:SETPoint:AC?", .callback = rffe_get_temp_ac,},
@@ -88,8 +96,18 @@ const scpi_command_t scpi_commands[] =
     {.pattern = "GET:NETMask?", .callback = rffe_get_netmask,},
     {.pattern = "SET:DHCPMode", .callback = rffe_set_dhcp_mode,},
     {.pattern = "GET:DHCPMode?", .callback = rffe_get_dhcp_mode,},
+    {.pattern = "GET:DHCPLease?", .callback = rffe_get_dhcp_lease,},
+    {.pattern = "SET:SYSLog", .callback = rffe_set_syslog,},
+    {.pattern = "GET:SYSLog?", .callback = rffe_get_syslog,},
     {.pattern = "GET:VERsion?", .callback = rffe_get_version,},
     {.pattern = "SYSTem:RESet", .callback = rffe_reset,},
+    {.pattern = "SYSTem:BOOT:TIMe?", .callback = rffe_get_boot_time,},
+    {.pattern = "SYSTem:STACk?", .callback = rffe_get_stack,},
+    {.pattern = "SYSTem:POOL?", .callback = rffe_get_pool,},
+    {.pattern = "SYSTem:PROFile?", .callback = rffe_get_profile,},
+    {.pattern = "SYSTem:PROFile:RESet", .callback = rffe_reset_profile,},
+    {.pattern = "SYSTem:STATistics?", .callback = rffe_get_statistics,},
+    {.pattern = "SYSTem:STATistics:RESet", .callback = rffe_reset_statistics,},
 
     SCPI_CMD_LIST_END
 };
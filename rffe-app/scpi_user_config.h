@@ -0,0 +1,56 @@
+/****************************************************************************
+ * rffe-app/scpi_user_config.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SCPI_USER_CONFIG_H_
+#define SCPI_USER_CONFIG_H_
+
+/*
+ * libscpi configuration (included by scpi/config.h with
+ * SCPI_USER_CONFIG defined)
+ */
+
+#include "profile.h"
+#include "cmd_stats.h"
+
+#define SCPI_HOOK_FIND_BEGIN(context)   PROFILE_START(scpi_find_start)
+#define SCPI_HOOK_FIND_END(context)     PROFILE_STOP(PROFILE_SCPI_FIND, scpi_find_start)
+
+/*
+ * Command callbacks are timed for the hot path profile and the per
+ * command statistics (SYSTem:STATistics?), when either is enabled
+ */
+#if defined(CONFIG_EXAMPLES_RFFE_PROFILE) || defined(CONFIG_EXAMPLES_RFFE_CMD_STATS)
+#define SCPI_HOOK_CALLBACK_BEGIN(context, cmd) \
+    uint32_t scpi_callback_start = profile_cycles()
+#define SCPI_HOOK_CALLBACK_END(context, cmd, result) \
+    do \
+    { \
+        uint32_t scpi_callback_cycles = profile_cycles() - scpi_callback_start; \
+        PROFILE_RECORD(PROFILE_COMMAND((cmd) - (context)->cmdlist), scpi_callback_cycles); \
+        CMD_STATS_RECORD((cmd) - (context)->cmdlist, \
+                         (result) != SCPI_RES_OK || (context)->cmd_error, \
+                         scpi_callback_cycles); \
+    } while (0)
+#endif
+
+#endif
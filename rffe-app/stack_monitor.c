@@ -0,0 +1,154 @@
+/****************************************************************************
+ * rffe-app/stack_monitor.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/arch.h>
+#include <nuttx/sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "stack_monitor.h"
+
+struct stack_walk
+{
+    struct stack_info* info;
+    int max;
+    int count;
+};
+
+/*
+ * Called by sched_foreach() with the scheduler locked, only copy what
+ * is needed
+ */
+static void stack_monitor_visit(FAR struct tcb_s* tcb, FAR void* arg)
+{
+    struct stack_walk* walk = arg;
+    struct stack_info* info;
+
+    if (walk->count >= walk->max || tcb->stack_alloc_ptr == NULL)
+    {
+        return;
+    }
+
+    info = &walk->info[walk->count++];
+    info->pid = tcb->pid;
+    info->size = tcb->adj_stack_size;
+#ifdef CONFIG_STACK_COLORATION
+    info->used = up_check_tcbstack(tcb);
+#else
+    info->used = 0;
+#endif
+#if CONFIG_TASK_NAME_SIZE > 0
+    strncpy(info->name, tcb->name, sizeof(info->name) - 1);
+    info->name[sizeof(info->name) - 1] = '\0';
+#else
+    info->name[0] = '\0';
+#endif
+}
+
+int stack_monitor_snapshot(struct stack_info* info, int max)
+{
+    struct stack_walk walk =
+    {
+        .info = info,
+        .max = max,
+        .count = 0,
+    };
+
+    sched_foreach(stack_monitor_visit, &walk);
+    return walk.count;
+}
+
+stack_status_t stack_monitor_status(const struct stack_info* info)
+{
+#ifdef CONFIG_STACK_COLORATION
+    int free = info->size - info->used;
+
+    if (free <= 0)
+    {
+        return STACK_STATUS_OVERFLOW;
+    }
+    if (free < STACK_MONITOR_MARGIN || free < info->size / 10)
+    {
+        return STACK_STATUS_LOW;
+    }
+    return STACK_STATUS_OK;
+#else
+    return STACK_STATUS_UNKNOWN;
+#endif
+}
+
+const char* stack_monitor_status_name(stack_status_t status)
+{
+    switch (status)
+    {
+    case STACK_STATUS_OK:
+        return "OK";
+    case STACK_STATUS_LOW:
+        return "LOW";
+    case STACK_STATUS_OVERFLOW:
+        return "OVERFLOW";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/*
+ * The snapshot is kept off the callers' stacks, they are the ones
+ * being measured
+ */
+static struct stack_info snapshot[STACK_MONITOR_MAX_TASKS];
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int stack_monitor_foreach(stack_monitor_cb_t cb, void* arg)
+{
+    int n;
+
+    pthread_mutex_lock(&snapshot_lock);
+    n = stack_monitor_snapshot(snapshot, STACK_MONITOR_MAX_TASKS);
+    for (int i = 0; i < n; i++)
+    {
+        cb(&snapshot[i], arg);
+    }
+    pthread_mutex_unlock(&snapshot_lock);
+
+    return n;
+}
+
+static void stack_monitor_print_task(const struct stack_info* info, void* arg)
+{
+    printf("%5d %-16s %5u %5u %5d %s\n", info->pid, info->name,
+           info->size, info->used, info->size - info->used,
+           stack_monitor_status_name(stack_monitor_status(info)));
+}
+
+void stack_monitor_print(void)
+{
+    printf("  PID NAME              SIZE  USED  FREE STATUS\n");
+    stack_monitor_foreach(stack_monitor_print_task, NULL);
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+ * rffe-app/stack_monitor.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef STACK_MONITOR_H_
+#define STACK_MONITOR_H_
+
+#include <nuttx/config.h>
+#include <sys/types.h>
+#include <stdint.h>
+
+/*
+ * Stack high-water marks of every task and thread, measured from the
+ * stack coloration (CONFIG_STACK_COLORATION): the deepest byte that
+ * no longer holds the fill pattern marks the maximum stack used since
+ * the task started.
+ *
+ * A task is reported as LOW when less than STACK_MONITOR_MARGIN bytes
+ * (or 10% of its stack) were never touched, and as OVERFLOW when the
+ * whole stack was used.
+ */
+
+#define STACK_MONITOR_MAX_TASKS CONFIG_MAX_TASKS
+#define STACK_MONITOR_MARGIN    128
+
+#ifdef CONFIG_TASK_NAME_SIZE
+#  define STACK_MONITOR_NAME_SIZE (CONFIG_TASK_NAME_SIZE + 1)
+#else
+#  define STACK_MONITOR_NAME_SIZE 1
+#endif
+
+typedef enum
+{
+    STACK_STATUS_OK,
+    STACK_STATUS_LOW,
+    STACK_STATUS_OVERFLOW,
+    STACK_STATUS_UNKNOWN, /* No stack coloration */
+} stack_status_t;
+
+struct stack_info
+{
+    pid_t pid;
+    char name[STACK_MONITOR_NAME_SIZE];
+    uint16_t size;
+    uint16_t used;
+};
+
+/**
+ * @brief Take a snapshot of the stack usage of all tasks
+ * @param info: Array to store the snapshot
+ * @param max: Number of entries of info
+ * @return Number of tasks stored
+ */
+int stack_monitor_snapshot(struct stack_info* info, int max);
+
+/**
+ * @brief Classify the stack usage of a task
+ */
+stack_status_t stack_monitor_status(const struct stack_info* info);
+
+/**
+ * @brief Name of a stack status ("OK", "LOW", "OVERFLOW" or "UNKNOWN")
+ */
+const char* stack_monitor_status_name(stack_status_t status);
+
+typedef void (*stack_monitor_cb_t)(const struct stack_info* info, void* arg);
+
+/**
+ * @brief Take a snapshot and call cb for every task, the snapshot is
+ * shared so only one caller runs at a time
+ * @return Number of tasks
+ */
+int stack_monitor_foreach(stack_monitor_cb_t cb, void* arg);
+
+/**
+ * @brief Print a table with the stack usage of all tasks to stdout
+ */
+void stack_monitor_print(void);
+
+#endif
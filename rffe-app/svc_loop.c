@@ -0,0 +1,104 @@
+/****************************************************************************
+ * rffe-app/svc_loop.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "svc_loop.h"
+#include "rffe_log.h"
+
+struct svc_loop_entry
+{
+    svc_loop_handler_t handler;
+    void* arg;
+};
+
+static struct pollfd svc_fds[SVC_LOOP_MAX_FDS];
+static struct svc_loop_entry svc_entries[SVC_LOOP_MAX_FDS];
+static int svc_count;
+
+int svc_loop_add(int fd, svc_loop_handler_t handler, void* arg)
+{
+    if (svc_count >= SVC_LOOP_MAX_FDS)
+    {
+        return -1;
+    }
+
+    svc_fds[svc_count].fd = fd;
+    svc_fds[svc_count].events = POLLIN;
+    svc_entries[svc_count].handler = handler;
+    svc_entries[svc_count].arg = arg;
+    svc_count++;
+    return 0;
+}
+
+static void* svc_loop_task(void* args)
+{
+    while (1)
+    {
+        int ret = poll(svc_fds, svc_count, -1);
+
+        if (ret < 0)
+        {
+            rffe_log_error("Service loop: poll failed (%d)", ret);
+            usleep(100000);
+            continue;
+        }
+
+        for (int i = 0; i < svc_count; i++)
+        {
+            if (svc_fds[i].revents != 0)
+            {
+                svc_entries[i].handler(svc_fds[i].fd, svc_entries[i].arg);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int svc_loop_start(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct sched_param param;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SVC_LOOP_STACK_SIZE);
+    param.sched_priority = SVC_LOOP_PRIORITY;
+    pthread_attr_setschedparam(&attr, &param);
+
+    if (pthread_create(&thread, &attr, &svc_loop_task, NULL) != 0)
+    {
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+ * rffe-app/svc_loop.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SVC_LOOP_H_
+#define SVC_LOOP_H_
+
+/*
+ * Shared service loop: a single thread poll()s the sockets of the
+ * mostly idle servers (firmware update listener, discovery responder)
+ * and calls their handlers, instead of one blocked thread (and stack)
+ * per server. Handlers must not block, long running work (a firmware
+ * update session) gets its own thread.
+ *
+ * The sockets must be opened by the rffe task (or one of its threads)
+ * so they belong to the task group of the loop thread.
+ */
+
+#define SVC_LOOP_MAX_FDS    4
+#define SVC_LOOP_PRIORITY   50
+#define SVC_LOOP_STACK_SIZE 1280
+
+typedef void (*svc_loop_handler_t)(int fd, void* arg);
+
+/**
+ * @brief Register a handler called when fd is readable, must be called
+ * before svc_loop_start()
+ * @return 0 if success, a negative number if there are no free slots
+ */
+int svc_loop_add(int fd, svc_loop_handler_t handler, void* arg);
+
+/**
+ * @brief Start the service loop thread
+ * @return 0 if success, a negative number otherwise
+ */
+int svc_loop_start(void);
+
+#endif
@@ -0,0 +1,214 @@
+/****************************************************************************
+ * rffe-app/syslog_sink.c
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/*
+ * Headers
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include "netutils/netlib.h"
+
+#include "syslog_sink.h"
+#include "rffe_log.h"
+#include "config_file.h"
+
+#define SYSLOG_FACILITY_LOCAL0 16
+
+static const char* cfg_file = "/dev/feram0";
+
+static pthread_mutex_t syslog_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sockaddr_in collector;
+static int syslog_sockfd = -1;
+static char hostname[12];
+
+/*
+ * Token bucket, in thousandths of a message so it can be refilled
+ * with millisecond resolution
+ */
+static uint32_t tokens;
+static uint32_t last_refill;
+
+static uint32_t sent, rate_dropped, errors;
+
+static int syslog_severity(int level)
+{
+    switch (level)
+    {
+    case RFFE_LOG_LEVEL_ERROR:
+        return 3;
+    case RFFE_LOG_LEVEL_WARN:
+        return 4;
+    case RFFE_LOG_LEVEL_INFO:
+        return 6;
+    default:
+        return 7;
+    }
+}
+
+static int syslog_take_token(uint32_t now)
+{
+    uint32_t elapsed = 0;
+
+    /*
+     * Timestamps are taken before the log buffer lock, concurrent
+     * writers may queue them slightly out of order
+     */
+    if ((int32_t)(now - last_refill) > 0)
+    {
+        elapsed = now - last_refill;
+        last_refill = now;
+    }
+    if (elapsed > SYSLOG_SINK_BURST * 1000 / SYSLOG_SINK_RATE)
+    {
+        elapsed = SYSLOG_SINK_BURST * 1000 / SYSLOG_SINK_RATE;
+    }
+
+    tokens += elapsed * SYSLOG_SINK_RATE;
+    if (tokens > SYSLOG_SINK_BURST * 1000)
+    {
+        tokens = SYSLOG_SINK_BURST * 1000;
+    }
+
+    if (tokens < 1000)
+    {
+        return 0;
+    }
+    tokens -= 1000;
+    return 1;
+}
+
+/*
+ * Called from the log task only, so a slow network never blocks the
+ * code that logged the message
+ */
+static void syslog_sink(int level, uint32_t timestamp, const char* msg)
+{
+    struct sockaddr_in dest;
+    char buf[160];
+    int n;
+
+    pthread_mutex_lock(&syslog_lock);
+    dest = collector;
+    pthread_mutex_unlock(&syslog_lock);
+
+    if (dest.sin_addr.s_addr == INADDR_ANY)
+    {
+        return;
+    }
+
+    /*
+     * The timestamp is the uptime at which the message was logged,
+     * use it to refill the bucket so a burst drained late from the
+     * log buffer is still limited
+     */
+    if (!syslog_take_token(timestamp))
+    {
+        rate_dropped++;
+        return;
+    }
+
+    if (syslog_sockfd < 0)
+    {
+        syslog_sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (syslog_sockfd < 0)
+        {
+            errors++;
+            return;
+        }
+    }
+
+    n = snprintf(buf, sizeof(buf), "<%d>1 - %s rffe - - - [%5lu.%03lu] %s",
+                 SYSLOG_FACILITY_LOCAL0 * 8 + syslog_severity(level), hostname,
+                 (unsigned long)(timestamp / 1000), (unsigned long)(timestamp % 1000),
+                 msg);
+    if (n >= sizeof(buf)) n = sizeof(buf) - 1;
+
+    if (sendto(syslog_sockfd, buf, n, MSG_DONTWAIT,
+               (struct sockaddr*)&dest, sizeof(dest)) < 0)
+    {
+        errors++;
+    }
+    else
+    {
+        sent++;
+    }
+}
+
+void syslog_sink_set_collector(in_addr_t addr, uint16_t port)
+{
+    /*
+     * A blank FeRAM reads as 255.255.255.255, never broadcast the log
+     */
+    if (addr == INADDR_NONE)
+    {
+        addr = INADDR_ANY;
+    }
+    if (port == 0 || port == 0xFFFF)
+    {
+        port = htons(SYSLOG_SINK_DEFAULT_PORT);
+    }
+
+    pthread_mutex_lock(&syslog_lock);
+    collector.sin_family = AF_INET;
+    collector.sin_addr.s_addr = addr;
+    collector.sin_port = port;
+    pthread_mutex_unlock(&syslog_lock);
+}
+
+int syslog_sink_start(void)
+{
+    in_addr_t addr = INADDR_ANY;
+    uint16_t port = 0;
+    uint8_t mac[6];
+
+    config_get_syslog_addr(cfg_file, &addr, &port);
+    syslog_sink_set_collector(addr, port);
+
+    netlib_getmacaddr("eth0", mac);
+    snprintf(hostname, sizeof(hostname), "rffe-%02x%02x%02x", mac[3], mac[4], mac[5]);
+
+    tokens = SYSLOG_SINK_BURST * 1000;
+
+    return rffe_log_add_sink(syslog_sink);
+}
+
+void syslog_sink_get_stats(struct syslog_sink_stats* stats)
+{
+    pthread_mutex_lock(&syslog_lock);
+    stats->addr = collector.sin_addr;
+    stats->port = ntohs(collector.sin_port);
+    pthread_mutex_unlock(&syslog_lock);
+
+    stats->sent = sent;
+    stats->rate_dropped = rate_dropped;
+    stats->errors = errors;
+    stats->log_dropped = rffe_log_dropped();
+}
@@ -0,0 +1,78 @@
+/****************************************************************************
+ * rffe-app/syslog_sink.h
+ *
+ *   Copyright (C) 2019 Augusto Fraga Giachero. All rights reserved.
+ *   Author: Augusto Fraga Giachero <afg@augustofg.net>
+ *
+ * This file is part of the RFFE firmware.
+ *
+ * RFFE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * RFFE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RFFE.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef SYSLOG_SINK_H_
+#define SYSLOG_SINK_H_
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+/*
+ * Remote log shipping: every message written by the rffe_log task is
+ * also sent as a RFC 5424 syslog datagram (facility local0, no
+ * timestamp, uptime in the message) to the collector stored in the
+ * FeRAM, e.g.:
+ *
+ * <134>1 - rffe-00a1b2 rffe - - - [  123.456] SCPI client connected
+ *
+ * A token bucket limits the sink to SYSLOG_SINK_RATE messages per
+ * second (bursts of SYSLOG_SINK_BURST), messages over the limit are
+ * dropped and counted, so a logging storm can't take more than about
+ * 1.5 KB/s of network bandwidth.
+ */
+
+#define SYSLOG_SINK_DEFAULT_PORT 514
+#define SYSLOG_SINK_RATE         10
+#define SYSLOG_SINK_BURST        20
+
+struct syslog_sink_stats
+{
+    struct in_addr addr;  /* INADDR_ANY if disabled */
+    uint16_t port;        /* Host order */
+    uint32_t sent;
+    uint32_t rate_dropped; /* Dropped by the rate limiter */
+    uint32_t errors;       /* Failed sends (no route, no buffers, ...) */
+    uint32_t log_dropped;  /* Dropped before, log buffer full */
+};
+
+/**
+ * @brief Register the syslog sink, using the collector from the
+ * config file (if any)
+ * @return 0 if success, a negative number otherwise
+ */
+int syslog_sink_start(void);
+
+/**
+ * @brief Change the collector, takes effect immediately
+ * @param addr: Collector IPv4 address, INADDR_ANY disables it
+ * (network order)
+ * @param port: Collector UDP port (network order)
+ */
+void syslog_sink_set_collector(in_addr_t addr, uint16_t port);
+
+/**
+ * @brief Read the sink counters
+ */
+void syslog_sink_get_stats(struct syslog_sink_stats* stats);
+
+#endif
@@ -25,102 +25,147 @@
 /*
  * Headers
  */
+#include <nuttx/config.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <stdlib.h>
+#include <pthread.h>
 
 #include "pid.h"
 #include "config_file.h"
+#include "profile.h"
+
+#define TEMP_CONTROL_STACK_SIZE 768
+#define TEMP_CONTROL_PERIOD_MS  100
 
 static const char* cfg_file = "/dev/feram0";
 static const char* dac_file = "/dev/dac0";
 
-struct dac_write_back
+/*
+ * Controller state, kept between iterations
+ */
+struct temp_control
 {
+    pid_ctrl_t pid_ac, pid_bd;
+    int temp_ac_fd, temp_bd_fd, dac_fd;
     float* dac_ac;
     float* dac_bd;
 };
 
+static struct temp_control tctrl_state;
+
 static int write_dac_voltage(int fd, int channel, float voltage)
 {
     uint16_t dac_val;
     uint8_t buf[3];
+    int ret;
 
     dac_val = (voltage / 3.3) * 4095.0;
     buf[0] = channel;
     buf[1] = dac_val & 0xFF;
     buf[2] = (dac_val >> 8) & 0xFF;
-    return write(fd, buf, 3);
+
+    PROFILE_START(start);
+    ret = write(fd, buf, 3);
+    PROFILE_STOP(PROFILE_DAC_WRITE, start);
+    return ret;
 }
 
-static void* temp_control_server(void* args)
+static int temp_control_init(struct temp_control* tc)
 {
-    pid_ctrl_t pid_ac, pid_bd;
-    float out_ac, out_bd, temp_ac, temp_bd;
-    int temp_ac_fd, temp_bd_fd, dac_fd;
-    b16_t temp;
-    temp_ctrl_mode_t tctrl;
-    struct dac_write_back* dac_out = args;
+    tc->temp_ac_fd = open("/dev/temp_ac", O_RDONLY);
+    tc->temp_bd_fd = open("/dev/temp_bd", O_RDONLY);
+    tc->dac_fd = open(dac_file, O_RDWR);
 
-    temp_ac_fd = open("/dev/temp_ac", O_RDONLY);
-    temp_bd_fd = open("/dev/temp_bd", O_RDONLY);
-    dac_fd = open(dac_file, O_RDWR);
-
-    if (temp_ac_fd < 0 || temp_bd_fd < 0)
+    if (tc->temp_ac_fd < 0 || tc->temp_bd_fd < 0)
     {
         puts("Temperature control error: temperature sensors not found!\n");
-        return NULL;
+        return -1;
     }
-    if (dac_fd < 0)
+    if (tc->dac_fd < 0)
     {
         puts("DAC device not found!\n");
-        return NULL;
+        return -1;
     }
 
-    pid_ac.inte_acc = 0.0;
-    pid_ac.last_in = 0.0;
-    pid_ac.out_max = 3.3;
-    pid_ac.out_min = 0.0;
-    pid_ac.sample_time = 0.1;
-    pid_bd.inte_acc = 0.0;
-    pid_bd.last_in = 0.0;
-    pid_bd.out_max = 3.3;
-    pid_bd.out_min = 0.0;
-    pid_bd.sample_time = 0.1;
+    tc->pid_ac.inte_acc = 0.0;
+    tc->pid_ac.last_in = 0.0;
+    tc->pid_ac.out_max = 3.3;
+    tc->pid_ac.out_min = 0.0;
+    tc->pid_ac.sample_time = TEMP_CONTROL_PERIOD_MS / 1000.0;
+    tc->pid_bd.inte_acc = 0.0;
+    tc->pid_bd.last_in = 0.0;
+    tc->pid_bd.out_max = 3.3;
+    tc->pid_bd.out_min = 0.0;
+    tc->pid_bd.sample_time = TEMP_CONTROL_PERIOD_MS / 1000.0;
+    return 0;
+}
 
-    while(1)
-    {
-        config_get_temp_control_mode(cfg_file, &tctrl);
+/*
+ * One control iteration: read the sensors, update the PID outputs in
+ * automatic mode and write the heater voltages
+ */
+static void temp_control_step(struct temp_control* tc)
+{
+    float temp_ac, temp_bd;
+    b16_t temp;
+    temp_ctrl_mode_t tctrl;
 
-        if (tctrl == TEMP_CTRL_AUTOMATIC)
-        {
-            config_get_pid_bd(cfg_file, &pid_bd.kp, &pid_bd.ki, &pid_bd.kd);
-            config_get_pid_ac(cfg_file, &pid_ac.kp, &pid_ac.ki, &pid_ac.kd);
-            config_get_setpoint_ac(cfg_file, &pid_ac.setpoint);
-            config_get_setpoint_bd(cfg_file, &pid_bd.setpoint);
+    PROFILE_START(start);
+    config_get_temp_control_mode(cfg_file, &tctrl);
+    PROFILE_STOP(PROFILE_CONFIG_READ, start);
 
-            read(temp_ac_fd, &temp, 4);
-            temp_ac = b16tof(temp);
-            read(temp_bd_fd, &temp, 4);
-            temp_bd = b16tof(temp);
+    if (tctrl == TEMP_CTRL_AUTOMATIC)
+    {
+        PROFILE_START(cfg_start);
+        config_get_pid_bd(cfg_file, &tc->pid_bd.kp, &tc->pid_bd.ki, &tc->pid_bd.kd);
+        config_get_pid_ac(cfg_file, &tc->pid_ac.kp, &tc->pid_ac.ki, &tc->pid_ac.kd);
+        config_get_setpoint_ac(cfg_file, &tc->pid_ac.setpoint);
+        config_get_setpoint_bd(cfg_file, &tc->pid_bd.setpoint);
+        PROFILE_STOP(PROFILE_CONFIG_READ, cfg_start);
+
+        PROFILE_START(ac_start);
+        read(tc->temp_ac_fd, &temp, 4);
+        PROFILE_STOP(PROFILE_SENSOR_READ, ac_start);
+        temp_ac = b16tof(temp);
+        PROFILE_START(bd_start);
+        read(tc->temp_bd_fd, &temp, 4);
+        PROFILE_STOP(PROFILE_SENSOR_READ, bd_start);
+        temp_bd = b16tof(temp);
+
+        PROFILE_START(pid_start);
+        *tc->dac_ac = pid_compute(&tc->pid_ac, temp_ac);
+        *tc->dac_bd = pid_compute(&tc->pid_bd, temp_bd);
+        PROFILE_STOP(PROFILE_PID_COMPUTE, pid_start);
+    }
 
-            out_ac = pid_compute(&pid_ac, temp_ac);
-            out_bd = pid_compute(&pid_bd, temp_bd);
+    write_dac_voltage(tc->dac_fd, 3, *tc->dac_ac);
+    write_dac_voltage(tc->dac_fd, 2, *tc->dac_bd);
+}
 
-            *dac_out->dac_ac = out_ac;
-            *dac_out->dac_bd = out_bd;
-        }
+/*
+ * The controller keeps its own thread even with
+ * CONFIG_EXAMPLES_RFFE_SHARED_SERVICES: each iteration blocks on FeRAM,
+ * sensor and DAC transfers, which would hold up the low priority work
+ * queue the Ethernet driver runs on.
+ */
+static void* temp_control_server(void* args)
+{
+    struct temp_control* tc = args;
 
-        write_dac_voltage(dac_fd, 3, *dac_out->dac_ac);
-        write_dac_voltage(dac_fd, 2, *dac_out->dac_bd);
+    if (temp_control_init(tc) < 0)
+    {
+        return NULL;
+    }
 
-        usleep(100000);
+    while(1)
+    {
+        temp_control_step(tc);
+        usleep(TEMP_CONTROL_PERIOD_MS * 1000);
     }
 
-    free(args);
     return NULL;
 }
 
@@ -129,13 +174,11 @@ void start_temp_control_server(float* dac_ac, float* dac_bd)
     pthread_t thread;
     pthread_attr_t attr;
 
-    struct dac_write_back* arg = malloc(sizeof(struct dac_write_back));
-
-    arg->dac_ac = dac_ac;
-    arg->dac_bd = dac_bd;
+    tctrl_state.dac_ac = dac_ac;
+    tctrl_state.dac_bd = dac_bd;
 
     pthread_attr_init(&attr);
-    pthread_attr_setstacksize(&attr, 768);
-    pthread_create(&thread, &attr, &temp_control_server, arg);
+    pthread_attr_setstacksize(&attr, TEMP_CONTROL_STACK_SIZE);
+    pthread_create(&thread, &attr, &temp_control_server, &tctrl_state);
     pthread_detach(thread);
 }
@@ -267,6 +267,18 @@
 
 #define BOARD_NLEDS 2
 
+/* DAT-31R5-SP attenuators (RF channels A to D on DATA_A to DATA_D). They
+ * share the clock and latch enable, so the driver shifts the same word to
+ * all of them. boardctl(BOARDIOC_ATT_SETCODES) takes BOARD_ATT_CHANNELS
+ * codes (0.5 dB steps) that replace that word, one per channel, on the
+ * next /dev/att0 write. A NULL argument disarms them.
+ */
+
+#define BOARD_ATT_CHANNELS    4
+#define BOARD_ATT_BITS        6
+
+#define BOARDIOC_ATT_SETCODES (BOARDIOC_USER + 0)
+
 /************************************************************************************
  * Public Types
  ************************************************************************************/
@@ -40,8 +40,10 @@
 #include <nuttx/config.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <syslog.h>
 #include <errno.h>
+#include <sys/boardctl.h>
 
 #include <nuttx/board.h>
 #include <nuttx/spi/spi.h>
@@ -54,26 +56,59 @@
 #include <nuttx/rf/dat-31r5-sp.h>
 #include <nuttx/leds/userled.h>
 
+#include <arch/board/board.h>
+
 #include "lpc17_40_gpio.h"
 #include "lpc17_40_ssp.h"
 #include "lpc17_40_i2c.h"
 
 #include "mbed.h"
 
+/* Per channel attenuator codes armed by BOARDIOC_ATT_SETCODES. While
+ * armed, the MOSI callbacks ignore the driver's bit and put the bit of
+ * each channel's own code on its DATA line (the driver shifts the 6 bit
+ * word MSB first, one SETMOSI/CLRMOSI per bit). Latching the word (LE
+ * high) disarms them.
+ */
+
+static FAR struct spi_dev_s *g_spi_att;
+static uint8_t g_att_codes[BOARD_ATT_CHANNELS];
+static bool g_att_armed;
+static int g_att_bit;
+
+static void spi_bitbang_mosi(bool level)
+{
+  bool data[BOARD_ATT_CHANNELS] =
+    {
+      level, level, level, level
+    };
+
+  int ch;
+
+  if (g_att_armed && g_att_bit < BOARD_ATT_BITS)
+    {
+      int shift = BOARD_ATT_BITS - 1 - g_att_bit++;
+
+      for (ch = 0; ch < BOARD_ATT_CHANNELS; ch++)
+        {
+          data[ch] = (g_att_codes[ch] >> shift) & 1;
+        }
+    }
+
+  lpc17_40_gpiowrite(DATA_A_DAT31R5SP, data[0]);
+  lpc17_40_gpiowrite(DATA_B_DAT31R5SP, data[1]);
+  lpc17_40_gpiowrite(DATA_C_DAT31R5SP, data[2]);
+  lpc17_40_gpiowrite(DATA_D_DAT31R5SP, data[3]);
+}
+
 static void spi_bitbang_set_mosi(void)
 {
-  lpc17_40_gpiowrite(DATA_A_DAT31R5SP, 1);
-  lpc17_40_gpiowrite(DATA_B_DAT31R5SP, 1);
-  lpc17_40_gpiowrite(DATA_C_DAT31R5SP, 1);
-  lpc17_40_gpiowrite(DATA_D_DAT31R5SP, 1);
+  spi_bitbang_mosi(true);
 }
 
 static void spi_bitbang_clear_mosi(void)
 {
-  lpc17_40_gpiowrite(DATA_A_DAT31R5SP, 0);
-  lpc17_40_gpiowrite(DATA_B_DAT31R5SP, 0);
-  lpc17_40_gpiowrite(DATA_C_DAT31R5SP, 0);
-  lpc17_40_gpiowrite(DATA_D_DAT31R5SP, 0);
+  spi_bitbang_mosi(false);
 }
 
 #define SPI_SETSCK  lpc17_40_gpiowrite(CLK_DAT31R5SP, 1)
@@ -96,6 +131,14 @@ static void spi_select(FAR struct spi_bitbang_s *priv, uint32_t devid,
   case SPIDEV_USER(1):
     /* When selected is true, LE = 1, otherwise LE = 0 */
     lpc17_40_gpiowrite(LE_DAT31R5SP, selected);
+
+    /* The per channel codes are used for a single word */
+
+    if (selected)
+      {
+        g_att_armed = false;
+        g_att_bit = 0;
+      }
     break;
 
   default:
@@ -263,6 +306,7 @@ int board_app_initialize(uintptr_t arg)
   dac_register("/dev/dac0", dac);
 
   spi_att = spi_create_bitbang(&g_spiops);
+  g_spi_att = spi_att;
 
   dat31r5sp_register("/dev/att0",
                      spi_att,
@@ -278,3 +322,59 @@ int board_app_initialize(uintptr_t arg)
   UNUSED(ret);
   return OK;
 }
+
+/****************************************************************************
+ * Name: board_ioctl
+ *
+ * Description:
+ *   Board specific boardctl() commands.  BOARDIOC_ATT_SETCODES arms one
+ *   code per attenuator (arg points to BOARD_ATT_CHANNELS uint8_t) for the
+ *   next /dev/att0 write, or disarms them (arg is NULL).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_BOARDCTL_IOCTL
+int board_ioctl(unsigned int cmd, uintptr_t arg)
+{
+  FAR const uint8_t *codes = (FAR const uint8_t *)arg;
+  int ch;
+
+  switch (cmd)
+    {
+    case BOARDIOC_ATT_SETCODES:
+      if (g_spi_att == NULL)
+        {
+          return -EINVAL;
+        }
+
+      if (codes == NULL)
+        {
+          SPI_LOCK(g_spi_att, true);
+          g_att_armed = false;
+          g_att_bit = 0;
+          SPI_LOCK(g_spi_att, false);
+          return OK;
+        }
+
+      for (ch = 0; ch < BOARD_ATT_CHANNELS; ch++)
+        {
+          if (codes[ch] >= (1 << BOARD_ATT_BITS))
+            {
+              return -EINVAL;
+            }
+        }
+
+      /* Don't change the codes in the middle of a word being shifted */
+
+      SPI_LOCK(g_spi_att, true);
+      memcpy(g_att_codes, codes, BOARD_ATT_CHANNELS);
+      g_att_bit = 0;
+      g_att_armed = true;
+      SPI_LOCK(g_spi_att, false);
+      return OK;
+
+    default:
+      return -ENOTTY;
+    }
+}
+#endif
@@ -0,0 +1,204 @@
+# -*- coding: utf-8 -*-
+
+"""Binary delta (bsdiff style) patch generator for RFFE firmware images.
+The patch format is described in rffe-app/delta.h.
+
+Matches between the old and new images are found through a hash of 8
+bytes seeds, then extended allowing mismatches, as bsdiff does: code that
+moved around keeps most of its bytes, only the relocated addresses end up
+as non zero diff bytes."""
+
+import struct
+import sys
+
+SEED_LENGTH = 8
+MAX_CANDIDATES = 16
+MIN_MATCH = 16
+
+def __match_length__(a, a_pos, b, b_pos):
+    length = 0
+    max_len = min(len(a) - a_pos, len(b) - b_pos)
+    step = 64
+    while length < max_len:
+        n = min(step, max_len - length)
+        if a[a_pos + length:a_pos + length + n] == b[b_pos + length:b_pos + length + n]:
+            length += n
+        elif n == 1:
+            break
+        else:
+            step = max(1, n // 2)
+    return length
+
+def __find_match__(old, index, new, scan):
+    best_len = 0
+    best_pos = 0
+    for cand in index.get(new[scan:scan + SEED_LENGTH], ()):
+        length = __match_length__(old, cand, new, scan)
+        if length > best_len:
+            best_len = length
+            best_pos = cand
+    return best_pos, best_len
+
+def __encode_diff__(old, old_pos, new, new_pos, length):
+    out = bytearray()
+    i = 0
+    while i < length:
+        d = (new[new_pos + i] - old[old_pos + i]) & 0xFF
+        if d != 0:
+            out.append(d)
+            i += 1
+            continue
+        run = 1
+        while run < 256 and i + run < length and new[new_pos + i + run] == old[old_pos + i + run]:
+            run += 1
+        out.append(0)
+        out.append(run - 1)
+        i += run
+    return out
+
+def diff(old, new):
+    """Returns the patch that rebuilds 'new' from 'old'"""
+    old = bytes(old)
+    new = bytes(new)
+
+    index = {}
+    for i in range(len(old) - SEED_LENGTH + 1):
+        chain = index.setdefault(old[i:i + SEED_LENGTH], [])
+        if len(chain) < MAX_CANDIDATES:
+            chain.append(i)
+
+    records = []
+    scan = 0
+    lastscan = 0
+    lastpos = 0
+    lastoffset = 0
+
+    while lastscan < len(new):
+        if scan >= len(new):
+            # Flush the last record
+            pos, length = len(old), 0
+            scan = len(new)
+        else:
+            pos, length = __find_match__(old, index, new, scan)
+
+            if length < MIN_MATCH:
+                scan += 1
+                continue
+
+            if pos - scan == lastoffset:
+                # Same alignment as the previous match, keep extending it
+                scan += length
+                continue
+
+            # Only switch alignment if the new match is clearly better
+            oldscore = 0
+            for i in range(scan, scan + length):
+                if 0 <= i + lastoffset < len(old) and old[i + lastoffset] == new[i]:
+                    oldscore += 1
+            if length <= oldscore + 8:
+                scan += length
+                continue
+
+        # Extend the previous match forward, allowing mismatches
+        s = 0
+        sf = 0
+        lenf = 0
+        i = 0
+        while lastscan + i < scan and lastpos + i < len(old):
+            if old[lastpos + i] == new[lastscan + i]:
+                s += 1
+            i += 1
+            if s * 2 - i > sf * 2 - lenf:
+                sf = s
+                lenf = i
+
+        # Extend the new match backward, allowing mismatches
+        lenb = 0
+        if scan < len(new):
+            s = 0
+            sb = 0
+            i = 1
+            while scan >= lastscan + i and pos >= i:
+                if old[pos - i] == new[scan - i]:
+                    s += 1
+                if s * 2 - i > sb * 2 - lenb:
+                    sb = s
+                    lenb = i
+                i += 1
+
+        # Both extensions overlap, split them where it matches best
+        if lastscan + lenf > scan - lenb:
+            overlap = (lastscan + lenf) - (scan - lenb)
+            s = 0
+            ss = 0
+            lens = 0
+            for i in range(overlap):
+                if new[lastscan + lenf - overlap + i] == old[lastpos + lenf - overlap + i]:
+                    s += 1
+                if new[scan - lenb + i] == old[pos - lenb + i]:
+                    s -= 1
+                if s > ss:
+                    ss = s
+                    lens = i + 1
+            lenf += lens - overlap
+            lenb -= lens
+
+        extra = new[lastscan + lenf:scan - lenb]
+        seek = (pos - lenb) - (lastpos + lenf)
+        records.append((lastpos, lastscan, lenf, extra, seek))
+
+        lastscan = scan - lenb
+        lastpos = pos - lenb
+        lastoffset = pos - scan
+        scan += length
+
+    out = bytearray()
+    for old_pos, new_pos, lenf, extra, seek in records:
+        out.extend(struct.pack("<IIi", lenf, len(extra), seek))
+        out.extend(__encode_diff__(old, old_pos, new, new_pos, lenf))
+        out.extend(extra)
+    return bytes(out)
+
+def patch(old, data):
+    """Applies a patch, reference implementation of the device decoder"""
+    old = bytes(old)
+    out = bytearray()
+    old_pos = 0
+    pos = 0
+    while pos < len(data):
+        diff_len, extra_len, seek = struct.unpack_from("<IIi", data, pos)
+        pos += 12
+        while diff_len > 0:
+            d = data[pos]
+            pos += 1
+            run = 1
+            if d == 0:
+                run = data[pos] + 1
+                pos += 1
+            for i in range(run):
+                out.append((old[old_pos] + d) & 0xFF)
+                old_pos += 1
+            diff_len -= run
+        out.extend(data[pos:pos + extra_len])
+        pos += extra_len
+        old_pos += seek
+    return bytes(out)
+
+if __name__ == "__main__":
+    if len(sys.argv) != 4:
+        print("Usage: " + sys.argv[0] + " old_image new_image patch_file")
+        exit(1)
+
+    with open(sys.argv[1], "rb") as f:
+        old = f.read()
+    with open(sys.argv[2], "rb") as f:
+        new = f.read()
+
+    data = diff(old, new)
+    if patch(old, data) != new:
+        print("Patch verification failed!")
+        exit(1)
+
+    with open(sys.argv[3], "wb") as f:
+        f.write(data)
+    print("{} bytes patch ({:.1f}% of the new image)".format(len(data), 100.0 * len(data) / max(1, len(new))))
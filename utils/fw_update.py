@@ -8,16 +8,16 @@ try:
     fw_file = sys.argv[2]
     version = sys.argv[3]
 except:
-    print("Usage: " + sys.argv[0] + " ip firmware_file version [bootloader]")
+    print("Usage: " + sys.argv[0] + " ip firmware_file version [bootloader | base=running_firmware_file]")
     exit(1)
 
 boot = False
-try:
-    boot_arg = sys.argv[4]
-    if (boot_arg == "bootloader"):
+base = None
+for arg in sys.argv[4:]:
+    if (arg == "bootloader"):
         boot = True
-except:
-    pass
+    elif arg.startswith("base="):
+        base = arg[len("base="):]
 
 print("Connecting to " + ip_addr + " ...")
 try:
@@ -27,5 +27,9 @@ except:
     exit(1)
 
 print("Connection established, writing new firmware...")
-rffe.reprogram(fw_file, version, boot)
+stats = rffe.reprogram(fw_file, version, boot, base)
+if stats:
+    print("{} bytes sent, {} pages written, erase {} ms, program {} ms, {:.1f} KiB/s".format(
+        stats["bytes_received"], stats["pages_written"], stats["erase_us"] // 1000,
+        stats["program_us"] // 1000, stats["throughput"] / 1024.0))
 print("Finished!")
@@ -0,0 +1,63 @@
+# -*- coding: utf-8 -*-
+
+"""LZSS compressor for RFFE firmware images. The stream format is
+described in rffe-app/lzss.h (4 KiB window, 3 to 18 bytes matches)."""
+
+MAX_DISTANCE = 4096
+MIN_LENGTH = 3
+MAX_LENGTH = 18
+MAX_CHAIN = 64
+
+def compress(data):
+    data = bytes(data)
+    out = bytearray()
+    chains = {}
+    pos = 0
+    flags_pos = None
+    flag_bit = 8
+
+    while pos < len(data):
+        if flag_bit == 8:
+            flags_pos = len(out)
+            out.append(0)
+            flag_bit = 0
+
+        best_len = 0
+        best_dist = 0
+        key = data[pos:pos + MIN_LENGTH]
+        if len(key) == MIN_LENGTH:
+            max_len = min(MAX_LENGTH, len(data) - pos)
+            for cand in reversed(chains.get(key, [])):
+                dist = pos - cand
+                if dist > MAX_DISTANCE:
+                    break
+                length = MIN_LENGTH
+                while length < max_len and data[cand + length] == data[pos + length]:
+                    length += 1
+                if length > best_len:
+                    best_len = length
+                    best_dist = dist
+                    if length == max_len:
+                        break
+
+        if best_len >= MIN_LENGTH:
+            out[flags_pos] |= 1 << flag_bit
+            out.append((best_dist - 1) & 0xFF)
+            out.append((((best_dist - 1) >> 8) << 4) | (best_len - MIN_LENGTH))
+            step = best_len
+        else:
+            out.append(data[pos])
+            step = 1
+
+        for i in range(pos, pos + step):
+            k = data[i:i + MIN_LENGTH]
+            if len(k) == MIN_LENGTH:
+                chain = chains.setdefault(k, [])
+                chain.append(i)
+                if len(chain) > MAX_CHAIN:
+                    del chain[0]
+
+        pos += step
+        flag_bit += 1
+
+    return bytes(out)
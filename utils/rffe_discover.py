@@ -0,0 +1,13 @@
+#!/usr/bin/env python
+
+import sys
+from rffe_nuttx_lib import *
+
+broadcast = sys.argv[1] if len(sys.argv) > 1 else "255.255.255.255"
+
+boards = discover(broadcast)
+for b in sorted(boards, key=lambda b: b.get("ip", "")):
+    print("{:<16} {:<18} {:<12} uptime {:>8} s  att {:>5} dB  dhcp {}".format(
+        b.get("ip", "?"), b.get("mac", "?"), b.get("tag", "?"), b.get("uptime", "?"),
+        b.get("att", "?"), b.get("dhcp", "?")))
+print("{} board(s) found".format(len(boards)))
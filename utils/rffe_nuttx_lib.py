@@ -1,12 +1,117 @@
 # -*- coding: utf-8 -*-
 
 import socket
+import struct
 import re
+import time
+import zlib
+import lzss
+import delta
+
+def discover(broadcast="255.255.255.255", port=9002, timeout=1.0):
+    """Broadcast a discovery probe and collect the answers of every RFFE board reached.
+    Returns a list of dictionaries (mac, ip, tag, uptime, att, tctrl, temp_ac, temp_bd, dhcp),
+    one per board"""
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    s.settimeout(timeout)
+    s.sendto(b"RFFE?", (broadcast, port))
+
+    boards = []
+    try:
+        while True:
+            data, addr = s.recvfrom(512)
+            fields = data.decode("UTF-8").split()
+            if not fields or fields[0] != "RFFE":
+                continue
+            boards.append(dict(f.split("=", 1) for f in fields[1:] if "=" in f))
+    except socket.timeout:
+        pass
+    s.close()
+    return boards
 
 class RFFEFWUpdate:
-    def __init__(self, ip_addr, port = 9090):
+    def __init__(self, ip_addr, port = 9090, window = 16):
+        self.addr = (ip_addr, port)
         self.s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        self.s.connect((ip_addr, port))
+        self.s.connect(self.addr)
+        self.window = window
+        self.proto = None
+
+    def reconnect(self):
+        self.s.close()
+        self.s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.s.connect(self.addr)
+
+    def __recv_exact__(self, length):
+        buf = bytearray()
+        while len(buf) < length:
+            data = self.s.recv(length - len(buf))
+            if not data:
+                raise socket.error("connection closed by the device")
+            buf.extend(data)
+        return bytes(buf)
+
+    def protocol_version(self):
+        """Returns the update protocol version supported by the device (1: page by page
+        writes only, 2: streaming writes, 3: LZSS compressed writes, 4: image header, 5: delta writes, 6: resumable sessions,
+        7: flow controlled compressed and delta writes)"""
+        self.s.send(b"v")
+        ans = self.__recv_exact__(1)
+        self.proto = 1 if ans == b"0" else int(ans)
+        return self.proto
+
+    def __recv_stream_ack__(self):
+        status, pages = struct.unpack("<cI", self.__recv_exact__(5))
+        if status != b"1":
+            raise Exception("streaming write failed after {} pages".format(pages))
+        return pages
+
+    def write_stream(self, data, start_addr):
+        """Write data to flash keeping up to 'window' pages in flight. The data length
+        should be a multiple of 256 bytes, and the start address should be 256 bytes aligned"""
+        if (len(data) % 256) != 0:
+            raise Exception("data length should be a multiple of 256 bytes")
+
+        if ((start_addr % 256) != 0):
+            raise Exception("start_addr should be a 256 bytes aligned")
+
+        npages = len(data) // 256
+        self.s.send(b"W" + struct.pack("<II", start_addr, npages))
+
+        sent = 0
+        acked = 0
+        while acked < npages:
+            while sent < npages and (sent - acked) < self.window:
+                self.s.sendall(data[sent * 256:(sent + 1) * 256])
+                sent += 1
+            acked = self.__recv_stream_ack__()
+
+    def __send_packed__(self, packed):
+        """Send a compressed or delta stream and wait for its final ack. With protocol
+        version 7 or later, up to 'window' pages of the stream are kept in flight, like
+        write_stream() (the device acks the stream bytes it consumed every few pages)"""
+        if self.proto is None or self.proto < 7:
+            try:
+                self.s.sendall(packed)
+            except socket.error:
+                pass
+            return self.__recv_stream_ack__()
+
+        sent = 0
+        acked = 0
+        while True:
+            end = min(len(packed), acked + self.window * 256)
+            if sent < end:
+                self.s.sendall(packed[sent:end])
+                sent = end
+            status, value = struct.unpack("<cI", self.__recv_exact__(5))
+            if status != b"p":
+                break
+            acked = value
+        if status != b"1":
+            raise Exception("streaming write failed after {} pages".format(value))
+        return value
 
     def erase_all(self):
         self.s.send(b"e")
@@ -29,43 +134,140 @@ class RFFEFWUpdate:
         self.s.send(addr)
         self.s.send(data)
         ans = self.s.recv(1)
+        return ans == b"1"
+
+    def send_header(self, size, crc, version, fw_type):
+        """Announce the image size, CRC-32 and version. Devices with protocol version 4 or
+        later only arm the bootloader if the staged image matches it"""
+        self.s.send(b"h" + struct.pack("<II4B", size, crc, version[0], version[1], version[2], fw_type))
+        if self.__recv_exact__(1) != b"1":
+            raise Exception("image header rejected by the device")
+
+    def write_compressed(self, data, start_addr):
+        """Compress data (LZSS) and write it to flash, the device decompresses it on the fly.
+        The start address should be 256 bytes aligned"""
+        if ((start_addr % 256) != 0):
+            raise Exception("start_addr should be a 256 bytes aligned")
 
-    def reprogram(self, file_path, version, bootloader=False):
-        major, minor, patch = map(int,re.split('[., _]',version))
+        packed = lzss.compress(data)
+        self.s.send(b"Z" + struct.pack("<III", start_addr, len(data), len(packed)))
+        self.__send_packed__(packed)
 
-        start_addr = 0x48000
+    def write_delta(self, base, data, start_addr):
+        """Write data to flash as a binary patch against base, the image the device is
+        currently running. The device rebuilds data from its application area and the patch.
+        The start address should be 256 bytes aligned"""
+        if ((start_addr % 256) != 0):
+            raise Exception("start_addr should be a 256 bytes aligned")
 
+        packed = delta.diff(base, data)
+        self.s.send(b"D" + struct.pack("<IIIII", start_addr, len(data), len(packed),
+                                       len(base), zlib.crc32(bytes(base)) & 0xFFFFFFFF))
+        self.__send_packed__(packed)
+
+    def query_pages(self):
+        """Returns the index of the first staging page not written yet in the current
+        session, and the written pages bitmap (page 0 is bit 0 of the first byte)"""
+        self.s.send(b"q")
+        status, first = struct.unpack("<cI", self.__recv_exact__(5))
+        bitmap = self.__recv_exact__(0x38000 // 256 // 8)
+        return first, bitmap
+
+    def status(self):
+        """Returns the current update session statistics as a dictionary"""
+        self.s.send(b"s")
+        fields = struct.unpack("<c7I", self.__recv_exact__(29))[1:]
+        keys = ("bytes_received", "pages_written", "sectors_erased", "erase_us",
+                "program_us", "elapsed_us", "throughput")
+        return dict(zip(keys, fields))
+
+    def resume(self, image, start_addr):
+        """Send the pages of image the device is still missing, after a dropped connection"""
+        first, bitmap = self.query_pages()
+        offset = first * 256 - (start_addr - 0x48000)
+        if offset < len(image):
+            self.write_stream(bytes(image[offset:]), start_addr + offset)
+
+    def __read_image__(self, file_path):
         with open(file_path, "rb") as f:
+            image = bytearray(f.read())
+
+        if (len(image) % 256) != 0:
+            image.extend(b'\377' * (256 - (len(image) % 256)))
+        return image
+
+    def reprogram(self, file_path, version, bootloader=False, base_path=None, retries=3):
+        """Reprogram the device. If base_path is given (application updates only), it
+        should be the image the device is currently running, and only a binary patch
+        against it is sent. With protocol version 6 or later, a dropped connection is
+        reopened and the upload resumed from the first missing page, up to 'retries' times
+        with an exponential backoff (0.5 s, doubled up to 8 s), and the session statistics
+        (see status()) are returned"""
+        major, minor, patch = map(int,re.split('[., _]',version))
 
-            self.erase_all()
-
-            buf = f.read(256)
-            while buf != b"":
-
-                pad = bytearray()
-                pad.extend(buf)
-
-                if len(buf) < 256:
-                    pad.extend(b'\377' * (256 - len(pad)))
+        start_addr = 0x48000
 
-                self.write_sector(pad, start_addr)
-                start_addr += 256
-                buf = f.read(256)
+        image = self.__read_image__(file_path)
+
+        proto = self.protocol_version()
+        fw_type = 2 if bootloader else 1
+
+        self.erase_all()
+
+        if proto >= 4:
+            self.send_header(len(image), zlib.crc32(bytes(image)) & 0xFFFFFFFF,
+                             (major, minor, patch), fw_type)
+
+        try:
+            if proto >= 5 and base_path is not None and not bootloader:
+                self.write_delta(bytes(self.__read_image__(base_path)), bytes(image), start_addr)
+            elif proto >= 3:
+                self.write_compressed(bytes(image), start_addr)
+            elif proto == 2:
+                self.write_stream(bytes(image), start_addr)
+            else:
+                for offset in range(0, len(image), 256):
+                    self.write_sector(bytes(image[offset:offset + 256]), start_addr + offset)
+        except socket.error:
+            if proto < 6:
+                raise
+            # Back off before each attempt, a dropped link often needs a moment to recover
+            delay = 0.5
+            while True:
+                time.sleep(delay)
+                try:
+                    self.reconnect()
+                    self.resume(image, start_addr)
+                    break
+                except socket.error:
+                    retries -= 1
+                    if retries <= 0:
+                        raise
+                    delay = min(delay * 2, 8.0)
 
         boot_sec = bytearray()
         boot_sec.extend(b'\377' * 256)
 
+        if not bootloader:
+            # CRC-32 of the vector table page, application length and CRC-32,
+            # checked by the bootloader at every boot
+            boot_sec[236:248] = struct.pack("<III", zlib.crc32(bytes(image[:256])) & 0xFFFFFFFF,
+                                            len(image), zlib.crc32(bytes(image)) & 0xFFFFFFFF)
         boot_sec[248] = major
         boot_sec[249] = minor
         boot_sec[250] = patch
-        boot_sec[251] = 2 if bootloader else 1
+        boot_sec[251] = fw_type
         boot_sec[252] = 0xAA
         boot_sec[253] = 0xAA
         boot_sec[254] = 0xAA
         boot_sec[255] = 0xAA
-        self.write_sector(boot_sec, 0x0007FF00)
+        if not self.write_sector(boot_sec, 0x0007FF00):
+            self.close()
+            raise Exception("image verification failed, the update was not armed")
+        stats = self.status() if proto >= 6 else None
         self.reset()
         self.close()
+        return stats
 
     def reset(self):
         self.s.send(b"r")
@@ -101,6 +303,22 @@ class RFFEControllerBoard:
                     break
         return buf.decode("UTF-8")
 
+    def __sock_recv_block__(self):
+        """Receive a SCPI definite length arbitrary block (#<n><len><data>)"""
+        while self.sock.recv(1) != b"#":
+            pass
+        ndigits = int(self.sock.recv(1))
+        length = int(self.__sock_recv_exact__(ndigits))
+        data = self.__sock_recv_exact__(length)
+        self.__sock_recv_line__()
+        return data
+
+    def __sock_recv_exact__(self, length):
+        buf = bytearray()
+        while len(buf) < length:
+            buf.extend(self.sock.recv(length - len(buf)))
+        return bytes(buf)
+
     def __scpi_request__(self, req):
         """SCPI request method"""
         ans = ""
@@ -121,6 +339,22 @@ class RFFEControllerBoard:
         0.5 dB step size."""
         self.__scpi_request__("SET:ATTEnuation {}".format(value))
 
+    def set_attenuator_calibration(self, channel, codes):
+        """Loads the calibration table of one attenuator channel ("A", "B", "C" or "D").
+        The codes argument is a list of 64 integers (0 to 63), the hardware code used for
+        each requested attenuation from 0 dB to 31.5 dB in 0.5 dB steps."""
+        if len(codes) != 64:
+            raise Exception("codes should be a 64 elements list")
+        data = bytes(codes)
+        header = "SET:ATTEnuation:CALibration:{} #2{}".format(channel, len(data))
+        self.sock.send(header.encode("UTF-8") + data + b"\n")
+
+    def get_attenuator_calibration(self, channel):
+        """Returns the calibration table of one attenuator channel ("A", "B", "C" or "D")
+        as a list of 64 integers."""
+        self.__sock_send_line__("GET:ATTEnuation:CALibration:{}?".format(channel))
+        return list(self.__sock_recv_block__())
+
     def get_temp_ac(self):
         """This method returns the temperature measured by the sensor present in the A/C
         front-end. The value returned is a floating-point number."""
@@ -183,17 +417,110 @@ class RFFEControllerBoard:
         argument, a floating-point number, is the intended voltage for the heater."""
         self.__scpi_request__("SET:DAC:OUTput:BD {}".format(value))
 
+    def get_dhcp_lease(self):
+        """Returns the DHCP lease state as a dictionary: state ("DISABLED", "INIT", "BOUND",
+        "RENEWING", "REBINDING" or "FALLBACK"), address, server, lease time and remaining
+        lease time (s), number of renewals and of failed requests"""
+        fields = self.__scpi_request__("GET:DHCPLease?").strip().split(",")
+        keys = ("state", "ip", "server", "lease_time", "remaining", "renewals", "failures")
+        values = [f.strip('"') for f in fields[:3]] + [int(f) for f in fields[3:]]
+        return dict(zip(keys, values))
+
+    def set_syslog(self, ip, port=514):
+        """Sets the remote syslog collector (saved to the FeRAM and applied immediately),
+        ip "0.0.0.0" disables log shipping"""
+        self.__scpi_request__("SET:SYSLog \"{}:{}\"".format(ip, port))
+
+    def get_syslog(self):
+        """Returns the remote syslog state as a dictionary: collector ip and port, messages
+        sent, dropped by the rate limiter, failed sends and messages dropped because the log
+        buffer was full"""
+        fields = self.__scpi_request__("GET:SYSLog?").strip().split(",")
+        keys = ("ip", "port", "sent", "rate_dropped", "errors", "log_dropped")
+        values = [fields[0].strip('"')] + [int(f) for f in fields[1:]]
+        return dict(zip(keys, values))
+
+    def get_boot_times(self):
+        """Returns a dictionary with the time (in ms since boot) each startup stage was
+        completed, None for stages not reached yet"""
+        keys = ("attenuation", "temp_control", "link_up", "listeners", "network")
+        values = [int(v) for v in self.__scpi_request__("SYSTem:BOOT:TIMe?").split(",")]
+        return dict(zip(keys, [v if v >= 0 else None for v in values]))
+
+    def get_stacks(self):
+        """Returns the stack usage of every task as a list of dictionaries: name, pid, size,
+        used (high-water mark) and free bytes and status ("OK", "LOW", "OVERFLOW" or
+        "UNKNOWN")"""
+        fields = self.__scpi_request__("SYSTem:STACk?").strip().split(",")
+        stacks = []
+        for i in range(0, len(fields) - 5, 6):
+            task = fields[i:i + 6]
+            stacks.append({"name": task[0].strip('"'), "pid": int(task[1]), "size": int(task[2]),
+                           "used": int(task[3]), "free": int(task[4]),
+                           "status": task[5].strip('"')})
+        return stacks
+
+    def get_pool(self):
+        """Returns the SCPI client context pool counters as a dictionary: capacity, contexts
+        in use, peak, connections accepted and connections rejected because the pool was
+        exhausted"""
+        keys = ("capacity", "in_use", "peak", "acquired", "failures")
+        values = [int(v) for v in self.__scpi_request__("SYSTem:POOL?").split(",")]
+        return dict(zip(keys, values))
+
+    def get_profile(self):
+        """Returns the hot path profile as a tuple: counter frequency in Hz and a list of
+        dictionaries, one per probe (name, count, min, max and total cycles). Only available
+        on firmware built with CONFIG_EXAMPLES_RFFE_PROFILE"""
+        fields = self.__scpi_request__("SYSTem:PROFile?").strip().split(",")
+        probes = []
+        for i in range(1, len(fields) - 4, 5):
+            probe = fields[i:i + 5]
+            probes.append({"name": probe[0].strip('"'), "count": int(probe[1]), "min": int(probe[2]),
+                           "max": int(probe[3]), "total": int(probe[4])})
+        return (int(fields[0]), probes)
+
+    def reset_profile(self):
+        """Clears the hot path profile counters"""
+        self.__scpi_request__("SYSTem:PROFile:RESet")
+
+    def get_statistics(self):
+        """Returns the per SCPI command statistics as a dictionary indexed by the command
+        pattern: invocation count, error count and latency histogram (bucket i counts the
+        calls that took 2^i to 2^(i+1) us, histogram buckets saturate at 65535). Empty unless the
+        firmware is built with CONFIG_EXAMPLES_RFFE_CMD_STATS"""
+        self.__sock_send_line__("SYSTem:STATistics?")
+        data = self.__sock_recv_block__()
+        version, nbuckets, nrecords = struct.unpack_from("<BBH", data, 0)
+        pos = 4
+        stats = {}
+        for i in range(nrecords):
+            index, name_len = struct.unpack_from("<BB", data, pos)
+            pos += 2
+            name = data[pos:pos + name_len].decode("UTF-8")
+            pos += name_len
+            values = struct.unpack_from("<II{}H".format(nbuckets), data, pos)
+            pos += 8 + 2 * nbuckets
+            stats[name] = {"index": index, "count": values[0], "errors": values[1],
+                           "histogram": list(values[2:])}
+        return stats
+
+    def reset_statistics(self):
+        """Clears the per SCPI command statistics"""
+        self.__scpi_request__("SYSTem:STATistics:RESet")
+
     def reset(self):
         """This method resets the board software."""
         self.__scpi_request__("SYSTem:RESet")
 
-    def reprogram(self, file_path, version, bootloader=False):
+    def reprogram(self, file_path, version, bootloader=False, base_path=None):
         """This method reprograms the mbed device on the RF front-end controller board. The
         first argument, a string, is the path to the binary file which corresponds to the
         program will be loaded in the device. The second argument is the new firmware version
-        formated as: x.y.z or x_y_z"""
+        formated as: x.y.z or x_y_z. The optional base_path is the binary currently running on
+        the device, when given only a binary patch is transferred"""
         rffe_fw = RFFEFWUpdate(self.ip)
-        rffe_fw.reprogram(file_path, version, bootloader);
+        return rffe_fw.reprogram(file_path, version, bootloader, base_path);
 
     def set_pid_ac_kc(self, value):
         """Sets the PID Kc parameter in the A/C front-end. The value is passed as a floating-point numpber."""
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""SCPI server load generator and latency benchmark.
+
+Opens several concurrent connections to the SCPI server (port 9001) and
+replays a command mix on each of them for a given time, then prints the
+throughput, the latency percentiles and the connections the server
+rejected as JSON, so the results of two firmware versions (or of the host
+build, rffe-app/host) can be compared.
+
+Commands are sent in batches of --pipeline commands written at once. The
+latency of a batch runs from its write to its last answer. A batch ending
+with a setter gets a *OPC? appended, so every batch has an answer to wait
+for. Setters write back the values read at startup ({att}, {setpoint_ac}
+and {setpoint_bd} in the mix), so a run doesn't change the board
+configuration.
+
+With --baseline, the results are compared with a previous run saved with
+--output, and the exit status is 1 if the throughput dropped or the p99
+latency grew by more than --tolerance percent."""
+
+import argparse
+import json
+import math
+import random
+import socket
+import sys
+import threading
+import time
+
+MIXES = {
+    "query": "MEASure:TEMPerature:AC?=4,MEASure:TEMPerature:BD?=4,GET:ATTEnuation?=2,"
+             "GET:TEMPerature:SETPoint:AC?=1,*IDN?=1",
+    "setter": "SET:ATTEnuation {att}=2,SET:TEMPerature:SETPoint:AC {setpoint_ac}=1,"
+              "SET:TEMPerature:SETPoint:BD {setpoint_bd}=1",
+    "mixed": "MEASure:TEMPerature:AC?=4,MEASure:TEMPerature:BD?=4,GET:ATTEnuation?=2,"
+             "SET:ATTEnuation {att}=1,SET:TEMPerature:SETPoint:AC {setpoint_ac}=1",
+}
+
+
+def parse_mix(spec, values):
+    """'command=weight,...' to a list of (command, weight)"""
+    mix = []
+    for item in spec.split(","):
+        command, _, weight = item.strip().rpartition("=")
+        if not command:
+            command, weight = weight, "1"
+        mix.append((command.format(**values), int(weight)))
+    return mix
+
+
+def is_query(command):
+    return command.rstrip().endswith("?")
+
+
+class Connection(threading.Thread):
+    def __init__(self, addr, mix, pipeline, timeout, seed, start, stop):
+        threading.Thread.__init__(self, daemon=True)
+        self.addr = addr
+        self.commands = [c for c, w in mix]
+        self.weights = [w for c, w in mix]
+        self.pipeline = pipeline
+        self.timeout = timeout
+        self.random = random.Random(seed)
+        self.start_event = start
+        self.stop_event = stop
+        self.latencies = []
+        self.requests = 0
+        self.status = "ok"
+        self.sock = None
+
+    def connect(self):
+        try:
+            self.sock = socket.create_connection(self.addr, self.timeout)
+            self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        except OSError:
+            self.status = "connect_failed"
+
+    def __recv_lines__(self, buf, count):
+        while buf.count(b"\n") < count:
+            data = self.sock.recv(4096)
+            if not data:
+                raise ConnectionResetError
+            buf.extend(data)
+        for i in range(count):
+            del buf[:buf.index(b"\n") + 1]
+
+    def run(self):
+        if self.sock is None:
+            return
+        buf = bytearray()
+        self.start_event.wait()
+        try:
+            while not self.stop_event.is_set():
+                batch = self.random.choices(self.commands, self.weights, k=self.pipeline)
+                answers = sum(1 for c in batch if is_query(c))
+                data = "\n".join(batch)
+                if not is_query(batch[-1]):
+                    data += "\n*OPC?"
+                    answers += 1
+                t0 = time.perf_counter()
+                self.sock.sendall((data + "\n").encode("UTF-8"))
+                self.__recv_lines__(buf, answers)
+                self.latencies.append(time.perf_counter() - t0)
+                self.requests += len(batch)
+        except socket.timeout:
+            self.status = "timeout"
+        except OSError:
+            # The server closes the connections it has no slot for
+            self.status = "rejected" if not self.latencies else "closed"
+        self.sock.close()
+
+
+def percentile(values, p):
+    """Nearest rank percentile of a sorted list"""
+    if not values:
+        return 0.0
+    rank = max(0, min(len(values), int(math.ceil(p / 100.0 * len(values)))) - 1)
+    return values[rank]
+
+
+def read_values(addr, timeout):
+    """Current values written back by the setters"""
+    s = socket.create_connection(addr, timeout)
+    f = s.makefile("rwb")
+    values = {}
+    for key, query in (("att", "GET:ATTEnuation?"), ("setpoint_ac", "GET:TEMPerature:SETPoint:AC?"),
+                       ("setpoint_bd", "GET:TEMPerature:SETPoint:BD?")):
+        f.write((query + "\n").encode("UTF-8"))
+        f.flush()
+        values[key] = f.readline().decode("UTF-8").strip()
+    s.close()
+    return values
+
+
+def run(args):
+    addr = (args.ip, args.port)
+    values = read_values(addr, args.timeout)
+    mix = parse_mix(MIXES.get(args.mix, args.mix), values)
+
+    start = threading.Event()
+    stop = threading.Event()
+    conns = [Connection(addr, mix, args.pipeline, args.timeout, args.seed + i, start, stop)
+             for i in range(args.connections)]
+    for c in conns:
+        c.connect()
+    for c in conns:
+        c.start()
+
+    # Let the server accept (or reject) every connection first
+    time.sleep(0.2)
+    t0 = time.perf_counter()
+    start.set()
+    time.sleep(args.duration)
+    stop.set()
+    for c in conns:
+        c.join(args.timeout + 1.0)
+    elapsed = time.perf_counter() - t0
+
+    latencies = sorted(l for c in conns for l in c.latencies)
+    requests = sum(c.requests for c in conns)
+    status = [c.status for c in conns]
+    ms = lambda v: round(v * 1000.0, 3)
+
+    return {
+        "target": "{}:{}".format(*addr),
+        "mix": mix,
+        "connections": args.connections,
+        "pipeline": args.pipeline,
+        "duration": round(elapsed, 3),
+        "requests": requests,
+        "batches": len(latencies),
+        "throughput": round(requests / elapsed, 1),
+        "latency_ms": {
+            "min": ms(latencies[0]) if latencies else 0.0,
+            "mean": ms(sum(latencies) / len(latencies)) if latencies else 0.0,
+            "p50": ms(percentile(latencies, 50)),
+            "p99": ms(percentile(latencies, 99)),
+            "p999": ms(percentile(latencies, 99.9)),
+            "max": ms(latencies[-1]) if latencies else 0.0,
+        },
+        "rejected": status.count("rejected") + status.count("connect_failed"),
+        "errors": status.count("timeout") + status.count("closed"),
+        "per_connection": [{"status": c.status, "requests": c.requests} for c in conns],
+    }
+
+
+def compare(result, baseline, tolerance):
+    """Prints the changes from the baseline, returns False on a regression"""
+    ok = True
+    checks = (("throughput", result["throughput"], baseline["throughput"], -1),
+              ("p50", result["latency_ms"]["p50"], baseline["latency_ms"]["p50"], 1),
+              ("p99", result["latency_ms"]["p99"], baseline["latency_ms"]["p99"], 1),
+              ("p999", result["latency_ms"]["p999"], baseline["latency_ms"]["p999"], 1))
+    for name, new, old, worse in checks:
+        change = 100.0 * (new - old) / old if old else 0.0
+        status = ""
+        if name in ("throughput", "p99") and change * worse > tolerance:
+            status = "  REGRESSION"
+            ok = False
+        print("{:<10} {:>12} -> {:>12} {:>+8.1f}%{}".format(name, old, new, change, status),
+              file=sys.stderr)
+    if result["rejected"] > baseline["rejected"]:
+        print("rejected   {:>12} -> {:>12}  REGRESSION".format(baseline["rejected"], result["rejected"]),
+              file=sys.stderr)
+        ok = False
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("ip", help="board (or host build) address")
+    parser.add_argument("--port", type=int, default=9001)
+    parser.add_argument("-c", "--connections", type=int, default=4,
+                        help="concurrent connections (the firmware accepts 4)")
+    parser.add_argument("-d", "--duration", type=float, default=10.0, help="seconds")
+    parser.add_argument("-m", "--mix", default="query",
+                        help="{} or 'command=weight,...'".format(", ".join(sorted(MIXES))))
+    parser.add_argument("-p", "--pipeline", type=int, default=1, help="commands written at once")
+    parser.add_argument("--timeout", type=float, default=5.0, help="answer timeout (s)")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("-o", "--output", help="also write the results to this file")
+    parser.add_argument("-b", "--baseline", help="results of a previous run to compare with")
+    parser.add_argument("--tolerance", type=float, default=10.0,
+                        help="allowed throughput and p99 regression (percent)")
+    args = parser.parse_args()
+
+    result = run(args)
+    text = json.dumps(result, indent=2)
+    print(text)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if not compare(result, baseline, args.tolerance):
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
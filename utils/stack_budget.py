@@ -0,0 +1,391 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Static stack depth and RAM budget of the RFFE firmware.
+
+Combines the per function frame sizes written by gcc -fstack-usage
+(.su files) with the call graph read from the disassembly of the final
+image, then walks it from each task entry point listed in the budget
+file to find its worst case stack. Functions without a .su file
+(assembly, prebuilt libraries) use the frame size found in their
+prologue.
+
+Calls through function pointers can't be seen in the disassembly, the
+budget file lists their possible targets. Unresolved indirect calls and
+dynamic stack allocations are reported. Recursive functions are walked
+down to the depth bound given in the budget file. Budget file patterns
+also match the clones made by gcc (foo.part.0, foo.isra.0, ...).
+
+The exit status is 1 when a task needs more stack than it is given,
+when a task's call graph has a recursion without a bound or when the
+heap can't hold the task stacks, so it can be used as a build gate. See
+rffe-app/stack_budget.cfg for the budget file format."""
+
+import argparse
+import fnmatch
+import os
+import re
+import subprocess
+import sys
+
+FUNC_RE = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+INSN_RE = re.compile(r"^\s*([0-9a-f]+):\s+(?:[0-9a-f]{2,8} )*\s*([a-z][a-z0-9.]*)\s*(.*)$")
+TARGET_RE = re.compile(r"<([^>+]+)(\+0x[0-9a-f]+)?>")
+REGLIST_RE = re.compile(r"\{([^}]*)\}")
+SUB_SP_RE = re.compile(r"sp,\s*(?:sp,\s*)?#(\d+)")
+X86_SUB_SP_RE = re.compile(r"\$0x([0-9a-f]+),%[re]sp")
+
+# ARM: bl/blx <sym> are calls, b <sym> to another function is a tail
+# call, blx/bx rN (other than lr) are calls through pointers. x86 is
+# handled as well, for the host build.
+CALLS = ("bl", "blx", "call", "callq")
+BRANCH_RE = re.compile(r"^(b(eq|ne|cs|cc|mi|pl|hi|ls|ge|lt|gt|le|hs|lo)?(\.[wn])?|jmpq?)$")
+
+# Suffixes of the function clones made by gcc optimizations
+CLONE_RE = re.compile(r"(\.(part|isra|constprop|cold|lto_priv)(\.\d+)?)+$")
+
+
+def base_name(func):
+    """Source level name of a function, without gcc clone suffixes"""
+    return CLONE_RE.sub("", func)
+
+
+def name_matches(func, pattern):
+    return fnmatch.fnmatchcase(func, pattern) or fnmatch.fnmatchcase(base_name(func), pattern)
+
+
+def parse_su(paths):
+    """Returns {function: (bytes, qualifiers)}, the largest frame is
+    kept for static functions with the same name"""
+    frames = {}
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                fields = line.rstrip("\n").split("\t")
+                if len(fields) < 3:
+                    continue
+                func = fields[0].rsplit(":", 1)[-1]
+                size = int(fields[1])
+                if func not in frames or frames[func][0] < size:
+                    frames[func] = (size, fields[2])
+    return frames
+
+
+def find_files(roots, suffix):
+    found = []
+    for root in roots:
+        for dirpath, _, files in os.walk(root, followlinks=True):
+            found.extend(os.path.join(dirpath, f) for f in files if f.endswith(suffix))
+    return found
+
+
+def prologue_frame(insns):
+    """Stack frame estimated from a function prologue"""
+    frame = 0
+    for mnemonic, args in insns[:6]:
+        if mnemonic.startswith("push") or mnemonic.startswith("stmdb"):
+            regs = REGLIST_RE.search(args)
+            if regs:
+                frame += 4 * len(regs.group(1).split(","))
+            elif mnemonic.startswith("push"):
+                frame += 8  # x86-64 push
+        elif mnemonic.startswith("sub"):
+            m = SUB_SP_RE.search(args)
+            if m and args.startswith("sp"):
+                frame += int(m.group(1))
+            m = X86_SUB_SP_RE.search(args)
+            if m:
+                frame += int(m.group(1), 16)
+    return frame
+
+
+def parse_disassembly(text):
+    """Returns {function: (callees, has_indirect_calls, prologue frame)}"""
+    funcs = {}
+    name = None
+    insns = []
+
+    def close():
+        if name is not None and name.endswith("@plt"):
+            # Host build, dynamically linked libc
+            funcs[name] = (set(), False, 0)
+        elif name is not None:
+            callees = set()
+            indirect = False
+            for mnemonic, args in insns:
+                target = TARGET_RE.search(args)
+                base = mnemonic.split(".")[0]
+                if base in CALLS:
+                    if target:
+                        callees.add(target.group(1))
+                    else:
+                        indirect = True
+                elif BRANCH_RE.match(mnemonic):
+                    if target and target.group(1) != name:
+                        callees.add(target.group(1))
+                    elif not target and args.startswith("*"):
+                        indirect = True
+                elif base == "bx" and not args.startswith("lr"):
+                    indirect = True
+            funcs[name] = (callees, indirect, prologue_frame(insns))
+
+    for line in text.splitlines():
+        m = FUNC_RE.match(line)
+        if m:
+            close()
+            name = m.group(2)
+            insns = []
+            continue
+        m = INSN_RE.match(line)
+        if m and name is not None:
+            insns.append((m.group(2), m.group(3)))
+    close()
+    return funcs
+
+
+def read_kconfig(path):
+    config = {}
+    if path and os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                m = re.match(r"^(CONFIG_\w+)=(.*)$", line.strip())
+                if m:
+                    config[m.group(1)] = m.group(2).strip('"')
+    return config
+
+
+def resolve_size(expr, kconfig, srcdir):
+    """A size is a number, a CONFIG_ option or file.c:MACRO"""
+    if expr.isdigit():
+        return int(expr)
+    if expr.startswith("CONFIG_"):
+        if expr not in kconfig:
+            raise ValueError(expr + " not found in the NuttX .config")
+        return int(kconfig[expr], 0)
+    path, macro = expr.split(":")
+    with open(os.path.join(srcdir, path)) as f:
+        m = re.search(r"^#define\s+" + macro + r"\s+(\d+)", f.read(), re.M)
+    if not m:
+        raise ValueError(expr + " not defined")
+    return int(m.group(1))
+
+
+def read_budget(path):
+    """Returns the [tasks] entries, the [calls] map, the [recursion]
+    bounds and the [margin] bytes from the budget file"""
+    tasks = []
+    calls = {}
+    recursion = {}
+    margin = 0
+    section = None
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            if line.startswith("["):
+                section = line.strip("[]")
+            elif section == "tasks":
+                fields = line.split()
+                count = int(fields[2].lstrip("x")) if len(fields) > 2 else 1
+                tasks.append((fields[0], fields[1], count))
+            elif section == "calls":
+                caller, targets = line.split(":", 1)
+                calls.setdefault(caller.strip(), []).extend(targets.split())
+            elif section == "recursion":
+                func, bound = line.split()
+                recursion[func] = int(bound)
+            elif section == "margin":
+                margin = int(line)
+    return tasks, calls, recursion, margin
+
+
+class CallGraph:
+    def __init__(self, funcs, frames, calls, recursion):
+        self.funcs = funcs
+        self.frames = frames
+        self.memo = {}
+        self.cycles = []
+        self.dynamic = set()
+        self.unresolved = set()
+        self.extra = {}
+        self.bounds = {}
+        for func in funcs:
+            for caller, patterns in calls.items():
+                if name_matches(func, caller):
+                    targets = self.extra.setdefault(func, set())
+                    for pattern in patterns:
+                        targets.update(f for f in funcs if name_matches(f, pattern))
+            for pattern, bound in recursion.items():
+                if name_matches(func, pattern):
+                    self.bounds[base_name(func)] = bound
+
+    def frame(self, func):
+        if func in self.frames:
+            size, qual = self.frames[func]
+            if "dynamic" in qual and "bounded" not in qual:
+                self.dynamic.add(func)
+            return size
+        return self.funcs.get(func, (set(), False, 0))[2]
+
+    def depth(self, func, path=()):
+        """Worst case stack below and including func, with the deepest
+        call chain. A function with a recursion bound appears at most
+        that many times in a chain (clones count as the function)."""
+        name = base_name(func)
+        # A clone called from its own wrapper (foo > foo.part.0) is the
+        # same call at the source level
+        def same_call(caller, callee):
+            return caller != callee and base_name(caller) == base_name(callee)
+
+        active = [base_name(f) for i, f in enumerate(path)
+                  if i == 0 or not same_call(path[i - 1], f)]
+        if name in self.bounds:
+            if (not path or not same_call(path[-1], func)) and active.count(name) >= self.bounds[name]:
+                return 0, []
+        elif func in path:
+            # A cycle through a bounded function is bounded as well
+            cycle = path[len(path) - 1 - path[::-1].index(func):] + (func,)
+            if not any(base_name(f) in self.bounds for f in cycle):
+                self.cycles.append(cycle)
+                return 0, [func]
+
+        # Results below a bounded recursion depend on how deep in it
+        # they are
+        key = (func, tuple(sorted((f, active.count(f)) for f in set(active) if f in self.bounds)))
+        if key in self.memo:
+            return self.memo[key]
+
+        callees, indirect, _ = self.funcs.get(func, (set(), False, 0))
+        callees = callees | self.extra.get(func, set())
+        if indirect and func not in self.extra:
+            self.unresolved.add(func)
+
+        best, chain = 0, []
+        for callee in sorted(callees):
+            d, c = self.depth(callee, path + (func,))
+            if d > best:
+                best, chain = d, c
+        result = (self.frame(func) + best, [func] + chain)
+        self.memo[key] = result
+        return result
+
+
+def section_sizes(objdump, elf):
+    sizes = {}
+    out = subprocess.check_output([objdump, "-h", elf], universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 3 and fields[0].isdigit():
+            sizes[fields[1]] = int(fields[2], 16)
+    return sizes
+
+
+def object_sizes(size_tool, objects):
+    """Returns [(object, data, bss)] sorted by RAM use"""
+    result = []
+    if not objects:
+        return result
+    out = subprocess.check_output([size_tool] + objects, universal_newlines=True)
+    for line in out.splitlines()[1:]:
+        fields = line.split()
+        if len(fields) >= 6:
+            result.append((os.path.basename(fields[5]), int(fields[1]), int(fields[2])))
+    return sorted(result, key=lambda r: r[1] + r[2], reverse=True)
+
+
+def ram_size(ldscript):
+    with open(ldscript) as f:
+        m = re.search(r"sram.*LENGTH\s*=\s*(\d+)([KM]?)", f.read())
+    scale = {"": 1, "K": 1024, "M": 1024 * 1024}[m.group(2)]
+    return int(m.group(1)) * scale
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("elf", help="linked image (nuttx/nuttx)")
+    parser.add_argument("dirs", nargs="+", help="directories searched for .su and rffe-app .o files")
+    parser.add_argument("--budget", default="rffe-app/stack_budget.cfg")
+    parser.add_argument("--config", default="nuttx/.config", help="NuttX .config")
+    parser.add_argument("--srcdir", default="rffe-app")
+    parser.add_argument("--ldscript", default="rffe-board/scripts/ld.script")
+    parser.add_argument("--cross", default="arm-none-eabi-", help="toolchain prefix")
+    args = parser.parse_args()
+
+    kconfig = read_kconfig(args.config)
+    tasks, calls, recursion, margin = read_budget(args.budget)
+
+    su_files = find_files(args.dirs, ".su")
+    if not su_files:
+        print("No .su files found, build with -fstack-usage first")
+        return 1
+    frames = parse_su(su_files)
+    disasm = subprocess.check_output([args.cross + "objdump", "-d", args.elf], universal_newlines=True)
+    graph = CallGraph(parse_disassembly(disasm), frames, calls, recursion)
+
+    failed = False
+    stack_total = 0
+
+    print("Stack budget ({} bytes margin for exception frames)".format(margin))
+    print("{:<24} {:>6} {:>6} {:>6}  deepest path".format("task", "size", "need", "free"))
+    for entry, size_expr, count in tasks:
+        size = resolve_size(size_expr, kconfig, args.srcdir)
+        if entry not in graph.funcs:
+            print("{:<24} {:>6} {:>6} {:>6}  (not in the image)".format(entry, size, "-", "-"))
+            continue
+        stack_total += size * count
+        need, chain = graph.depth(entry)
+        need += margin
+        status = ""
+        if need > size:
+            status = "  OVERFLOW"
+            failed = True
+        print("{:<24} {:>6} {:>6} {:>6}  {}{}".format(entry, size, need, size - need,
+                                                       " > ".join(chain), status))
+
+    for cycle in graph.cycles:
+        print("error: recursion, stack depth is unbounded (add a [recursion] bound): " + " > ".join(cycle))
+        failed = True
+    for func in sorted(graph.dynamic):
+        print("warning: {} allocates a dynamic amount of stack".format(func))
+    for func in sorted(graph.unresolved):
+        print("warning: unresolved indirect call in {}, list its targets in [calls]".format(func))
+
+    sections = section_sizes(args.cross + "objdump", args.elf)
+    data = sections.get(".data", 0)
+    bss = sections.get(".bss", 0)
+    ram = ram_size(args.ldscript)
+    idle = int(kconfig.get("CONFIG_IDLETHREAD_STACKSIZE", "1024"))
+    heap = ram - data - bss - idle
+
+    print("")
+    print("RAM budget (main SRAM)")
+    print("  {:<28} {:>6}".format("size", ram))
+    print("  {:<28} {:>6}".format(".data", data))
+    print("  {:<28} {:>6}".format(".bss", bss))
+    print("  {:<28} {:>6}".format("idle stack", idle))
+    print("  {:<28} {:>6}".format("heap", heap))
+    print("  {:<28} {:>6}".format("task stacks (from heap)", stack_total))
+    print("  {:<28} {:>6}".format("heap left", heap - stack_total))
+    if int(kconfig.get("CONFIG_MM_REGIONS", "1")) > 1:
+        print("  (CONFIG_MM_REGIONS > 1, the AHB SRAM heap regions are not counted)")
+    if heap - stack_total < 0:
+        print("error: the task stacks don't fit in the heap")
+        failed = True
+
+    srcdir = os.path.realpath(args.srcdir)
+    objects = [o for o in find_files(args.dirs, ".o") if os.path.realpath(o).startswith(srcdir)]
+    objects = sorted(set(os.path.realpath(o) for o in objects))
+    if objects:
+        print("")
+        print("rffe-app static RAM")
+        print("  {:<28} {:>6} {:>6}".format("object", ".data", ".bss"))
+        for obj, odata, obss in object_sizes(args.cross + "size", objects):
+            if odata + obss > 0:
+                print("  {:<28} {:>6} {:>6}".format(obj, odata, obss))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())